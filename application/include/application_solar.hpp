@@ -4,6 +4,50 @@
 #include "application.hpp"
 #include "model.hpp"
 #include "structs.hpp"
+#include "scene_graph.hpp"
+#include "body_store.hpp"
+#include "culling.hpp"
+#include "bvh.hpp"
+#include "nbody.hpp"
+#include "stream_buffer.hpp"
+#include "geometry_arena.hpp"
+#include "occlusion.hpp"
+#include "command_buffer.hpp"
+#include "triple_buffer.hpp"
+#include "texture_atlas.hpp"
+#include "asset_memory.hpp"
+#include "lod_selector.hpp"
+#include "light_clusters.hpp"
+#include "buffer_texture.hpp"
+
+#include <vector>
+
+// simulation state read by render, written on the main thread and rendered on the gl thread
+struct solar_snapshot
+{
+    glm::fmat4 view_transform;
+    //time of the rendered frame, blended between the last two steps
+    float time;
+    bool gravity;
+    bool occlusion_culling;
+    //presses of P so far, the body in the center of the view is printed when it grows,
+    //a count survives snapshots replaced before they were rendered
+    unsigned picks;
+    //simulated bodies followed by the asteroids, only filled in gravity mode
+    std::vector<glm::fvec3> positions;
+};
+
+// point light circling a body, the circle lies parallel to the orbit plane
+struct body_light
+{
+    std::uint32_t body;
+    orbit motion;
+    //offset of the circle above the body center
+    float height;
+    glm::fvec3 color;
+    float radius;
+    float intensity;
+};
 
 // gpu representation of model
 class ApplicationSolar : public Application {
@@ -15,28 +59,114 @@ class ApplicationSolar : public Application {
 
   // update uniform locations and values
   void uploadUniforms();
-    void uploadUniforms_p();
-    void uploadUniforms_s();
   // update projection matrix
   void updateProjection();
   // react to key input
   void keyCallback(int key, int scancode, int action, int mods);
+  // advance simulated time
+  void update(double delta_time);
+  // copy camera, time and simulated positions into the next snapshot
+  void publish();
+  // render the latest published snapshot
+  void acquire();
+  bool renders_snapshots() const;
   // draw all objects
   void render() const;
     
   void mouseScrollCallback(double x, double y);
-    
-  void upload_planet_transforms(planet const& model) const;
-    
-  float generate_random_numbers(float a, float b);
+  // print name of the body in the center of the rendered view
+  void pick_body() const;
 
  protected:
   void initializeShaderPrograms();
   void initializeGeometry();
-  void updateView();
+  void initializeScene();
+  void initializeSurfaces();
+  // account the loaded assets and free cpu copies the policy allows
+  void initializeAssets();
+  // place the Sun light and the lights circling the other bodies
+  void initializeLights();
+  // compute world space boxes of all bodies from the scene graph
+  void update_body_bounds() const;
+  // initialize gravity simulation from the current orbits
+  void start_gravity();
+  // copy simulated positions of the snapshot into the scene graph and asteroid buffer
+  void apply_gravity_positions() const;
+  // remove visible bodies hidden behind occluders
+  void cull_occluded() const;
+  // choose the level of detail of every visible body seen from the eye position
+  void select_lods(glm::fvec3 const& eye) const;
+  // mesh the body is drawn with at its current level of detail
+  std::uint32_t drawn_mesh(std::uint32_t body) const;
+  // move the lights with their bodies and transform them into view space
+  void update_lights(glm::fmat4 const& view_matrix, float time) const;
+  // assign the lights to the clusters and upload the lists for the planet shader
+  void upload_clusters() const;
+
+  // simulated time in seconds after the last and the previous update
+  double m_sim_time;
+  double m_last_sim_time;
+
+  // transform hierarchy, updated lazily during rendering
+  mutable scene_graph m_scene;
+  // copy of the hierarchy for the simulation thread, the rendered one belongs to the gl thread
+  scene_graph m_simulation_scene;
+  // bodies of the solar system
+  body_store m_bodies;
+  // cpu representation of meshes and their ranges in the shared geometry buffers, indexed by the body mesh handles
+  std::vector<model> m_mesh_models;
+  geometry_arena m_geometry;
+  std::vector<geometry_arena::mesh_range> m_meshes;
+  // surfaces of all bodies in one texture array, indexed by the body surface handles
+  texture_atlas m_surfaces;
+  // levels of the sphere meshes, the level of each body is kept between frames for the hysteresis
+  lod_selector m_sphere_lods;
+  mutable std::vector<std::uint8_t> m_body_lods;
+
+  // static hierarchy over the star field, stars are stored in its order
+  bvh m_star_bvh;
+  // hierarchy over the bodies, refitted every frame
+  mutable bvh m_body_bvh;
+  mutable std::vector<aabb> m_body_boxes;
+
+  // per frame culling data, kept to reuse allocations
+  mutable std::vector<std::uint32_t> m_visible;
+  mutable std::vector<bvh::range> m_star_ranges;
+  // depth of the large bodies, hides bodies behind them, toggled with O
+  bool m_occlusion_culling;
+  // picking is done when rendering the next snapshot, requested with P
+  unsigned m_pick_requests;
+  // requests already answered by the gl thread
+  mutable unsigned m_picks_handled;
+  mutable occlusion_buffer m_occlusion;
+
+  // gravity simulation replacing the circular orbits, toggled with G
+  bool m_gravity;
+  // solar bodies in table order, followed by the asteroids
+  nbody_system m_nbody;
+  barnes_hut m_gravity_tree;
+  gravity_settings m_gravity_settings;
+  model_object m_asteroids;
+  // gravity mode of the last rendered frame, static bodies are moved back when it ends
+  mutable bool m_rendered_gravity;
+
+  // handoff from the simulation to the rendering, slots keep their position buffers between frames
+  triple_buffer<solar_snapshot> m_snapshots;
 
-  // cpu representation of model
-  model_object planet_object;
+  // per instance matrices of the drawn bodies, rewritten every frame
+  mutable stream_buffer m_instance_stream;
+  // draws of the frame, recorded by worker threads and executed on the gl thread
+  mutable command_stream m_commands;
+  // lights moving with the bodies and their view space copies of the frame
+  std::vector<body_light> m_body_lights;
+  mutable std::vector<point_light> m_lights;
+  // lights of every cluster of the view frustum, rebuilt every frame and read by the planet shader
+  mutable light_clusters m_clusters;
+  mutable buffer_texture m_cluster_ranges;
+  mutable buffer_texture m_cluster_indices;
+  mutable buffer_texture m_light_data;
+  // accounting entries of the assets owned by the application
+  std::vector<asset_memory::handle> m_assets;
     
 };
 
@@ -3,7 +3,13 @@
 
 #include "utils.hpp"
 #include "shader_loader.hpp"
-#include "model_loader.hpp"
+#include "procedural_mesh.hpp"
+#include "star_field.hpp"
+#include "nbody.hpp"
+#include "frame_arena.hpp"
+#include "gl_commands.hpp"
+#include "texture_loader.hpp"
+#include "vertex_layout.hpp"
 
 #include <glbinding/gl/gl.h>
 // use gl definitions from glbinding 
@@ -17,223 +23,730 @@ using namespace gl;
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
 #include <iostream>
-#include <random>
-
-//we decided to declare these matrices here, because they are used in different fragments of the code and this solution seemed to be easier one than creating a special method for returning a value of it.
-glm::fmat4 model_matrix{};
-glm::fmat4 normal_matrix{};
-
-int number_of_stars = 3000;
-std::vector<GLfloat> stars{};
-
-std::random_device rd;     // only used once to initialise (seed) engine (needed for generate_random_numbers function
-
-model mercury_model{};
-model venus_model{};
-model earth_model{};
-model mars_model{};
-model jupiter_model{};
-model saturn_model{};
-model uranus_model{};
-model neptune_model{};
-model sun_model{};
-model moon_model{};
-model star_model{};
-//model star_model{stars, model::POSITION|model::NORMAL}; - this was throwing segmentation fault, so we had to create an empty model and "fill" it with values below in the constructor
-
-//function forcalculating a random float within the interval (a,b)
-float ApplicationSolar::generate_random_numbers(float a, float b)
+#include <string>
+
+const std::size_t number_of_stars = 3000;
+//fixed seed, the star field is the same on every start
+const std::uint32_t star_seed = 2016;
+//stars are placed in a cube with this half extent
+const float star_field_extent = 100.0f;
+std::vector<star_point> stars{};
+
+//maximum number of stars in a leaf of the hierarchy, every leaf is one vertex range
+const std::size_t stars_per_leaf = 64;
+
+//interleaved vertices of all body meshes
+typedef vertex_layout<position_attribute, normal_attribute, texcoord_attribute> body_mesh_layout;
+//stars and asteroids are points with tightly packed attributes
+typedef vertex_layout<vec3_attribute, color_attribute> star_layout;
+typedef vertex_layout<vec3_attribute> asteroid_layout;
+static_assert(sizeof(star_point) == star_layout::stride && offsetof(star_point, color) == layout_element<1, star_layout>::offset,
+              "star_point does not match the star layout");
+
+//per instance vertex attributes of a drawn body
+struct body_instance
 {
-    std::mt19937 rng(rd());                             // random-number engine used (Mersenne-Twister in this case)
-    std::uniform_real_distribution<float> uni(a,b);     // guaranteed unbiased
-    
-    auto random_float = uni(rng);
-    return random_float;
-}
+    glm::fmat4 model_matrix;
+    glm::fmat4 normal_matrix;
+    //offset and scale of the surface in its texture array layer
+    glm::fvec4 surface_rect;
+    float surface_layer;
+    //1 for bodies shining themselves, they are not lit
+    float emission;
+};
+typedef vertex_layout<mat4_attribute, mat4_attribute, vec4_attribute, float_attribute, float_attribute> body_instance_layout;
+static_assert(sizeof(body_instance) == body_instance_layout::stride
+              && offsetof(body_instance, normal_matrix) == layout_element<1, body_instance_layout>::offset
+              && offsetof(body_instance, surface_rect) == layout_element<2, body_instance_layout>::offset
+              && offsetof(body_instance, surface_layer) == layout_element<3, body_instance_layout>::offset
+              && offsetof(body_instance, emission) == layout_element<4, body_instance_layout>::offset,
+              "body_instance does not match the instance layout");
+//attribute locations of the instance data, matrices take one for each column, they follow position, normal and texture coordinates
+const GLuint INSTANCE_LOCATION = GLuint(body_mesh_layout::locations);
+const GLuint MODEL_MATRIX_LOCATION = 3;
+const GLuint NORMAL_MATRIX_LOCATION = 7;
+const GLuint SURFACE_RECT_LOCATION = 11;
+const GLuint SURFACE_LAYER_LOCATION = 12;
+const GLuint EMISSION_LOCATION = 13;
+//the shaders declare these locations, the layout has to produce the same ones
+static_assert(MODEL_MATRIX_LOCATION == INSTANCE_LOCATION + layout_element<0, body_instance_layout>::location
+              && NORMAL_MATRIX_LOCATION == INSTANCE_LOCATION + layout_element<1, body_instance_layout>::location
+              && SURFACE_RECT_LOCATION == INSTANCE_LOCATION + layout_element<2, body_instance_layout>::location
+              && SURFACE_LAYER_LOCATION == INSTANCE_LOCATION + layout_element<3, body_instance_layout>::location
+              && EMISSION_LOCATION == INSTANCE_LOCATION + layout_element<4, body_instance_layout>::location,
+              "instance attribute locations differ from the shaders");
+//surfaces of all bodies are bound once to this unit
+const GLuint SURFACE_TEXTURE_UNIT = 0;
+//buffer textures of the light clusters, also bound once
+const GLuint CLUSTER_RANGE_UNIT = 1;
+const GLuint CLUSTER_INDEX_UNIT = 2;
+const GLuint LIGHT_UNIT = 3;
+//upper bound of bodies drawn per frame, the farthest visible bodies beyond it are left out
+const std::size_t max_body_instances = 1024;
+//instanced draws are split into batches, so large groups are recorded by several threads
+const std::size_t instances_per_batch = 64;
+const std::size_t batches_per_job = 4;
+//size of the buffers shared by all meshes
+const std::size_t geometry_vertex_capacity = 1 << 18;
+const std::size_t geometry_index_capacity = 1 << 20;
+
+//subdivisions of the sphere levels from coarse to fine, 48 up to 12288 triangles
+const unsigned sphere_subdivisions[] = {2, 4, 8, 16, 32};
+//projected diameter as fraction of the viewport height from which the next finer level is drawn
+const float sphere_lod_thresholds[] = {0.02f, 0.06f, 0.15f, 0.4f};
+static_assert(sizeof(sphere_subdivisions) / sizeof(unsigned) == sizeof(sphere_lod_thresholds) / sizeof(float) + 1,
+              "every sphere level except the coarsest needs a threshold");
+//relative margin around the thresholds, bodies near one keep their level
+const float lod_hysteresis = 0.2f;
+//level rasterized for occluders, the vertices of coarser levels are part of all finer ones,
+//so the coarsest hull lies inside every level a body may be drawn with and culling stays conservative,
+//occluders are rasterized before the levels of the frame are selected
+const std::uint32_t occluder_level = 0;
 
+//clusters of the view frustum, the tiles follow the usual 16:9 window
+const unsigned cluster_tiles_x = 16;
+const unsigned cluster_tiles_y = 9;
+const unsigned cluster_slices = 24;
+//lights circling the planets and the Moon, all of them next to the Sun light
+const std::size_t number_of_body_lights = 255;
+const std::uint32_t light_seed = 23;
+//the falloff reaches zero at the radius, Neptune at a distance of 50 is still lit with 1.5 * (2 / 3)^2 = 0.67,
+//well above the ambient light
+const float sun_light_radius = 150.0f;
+const float sun_light_intensity = 1.5f;
+//light from no particular source, keeps the dark sides visible
+const float ambient_light = 0.1f;
 
 ApplicationSolar::ApplicationSolar(std::string const& resource_path)
  :Application{resource_path}
- ,planet_object{}
+ ,m_sim_time{0.0}
+ ,m_last_sim_time{0.0}
+ ,m_scene{}
+ ,m_simulation_scene{}
+ ,m_bodies{}
+ ,m_mesh_models{}
+ ,m_geometry{body_mesh_layout{}, geometry_vertex_capacity, geometry_index_capacity}
+ ,m_meshes{}
+ ,m_surfaces{}
+ ,m_sphere_lods{std::vector<float>(std::begin(sphere_lod_thresholds), std::end(sphere_lod_thresholds)), lod_hysteresis}
+ ,m_body_lods{}
+ ,m_star_bvh{}
+ ,m_body_bvh{}
+ ,m_body_boxes{}
+ ,m_visible{}
+ ,m_star_ranges{}
+ ,m_occlusion_culling{true}
+ ,m_pick_requests{0}
+ ,m_picks_handled{0}
+ ,m_occlusion{}
+ ,m_gravity{false}
+ ,m_nbody{}
+ ,m_gravity_tree{}
+ ,m_gravity_settings{}
+ ,m_asteroids{}
+ ,m_rendered_gravity{false}
+ ,m_snapshots{}
+ ,m_instance_stream{GL_ARRAY_BUFFER, max_body_instances * sizeof(body_instance)}
+ ,m_commands{}
+ ,m_body_lights{}
+ ,m_lights{}
+ ,m_clusters{cluster_tiles_x, cluster_tiles_y, cluster_slices}
+ ,m_cluster_ranges{GL_RG32UI, "cluster ranges"}
+ ,m_cluster_indices{GL_R32UI, "cluster light indices"}
+ ,m_light_data{GL_RGBA32F, "lights"}
+ ,m_assets{}
 {
-  int new_stars_size = number_of_stars * 3;
-    //here the container is being resized and filled with random X,Y,Z-position values of our stars
-  stars.resize(new_stars_size);
-    std::generate(stars.begin(), stars.end(),
-    [&]
-    {
-        return generate_random_numbers(-100.0f, 100.0f);
-    });
-    //and now, here we try to do what we wanted to before: create sth like model star_model{stars, model::POSITION|model::NORMAL}. For this we had to basically copy and modify a little bit the constructor from model.cpp file
-  star_model.data = stars;
-  model::attrib_flag_t contained_attributes = model::POSITION|model::NORMAL;
-  // number of components per vertex
-  std::size_t component_num = 0;
-    
-  for (auto const& supported_attribute : model::VERTEX_ATTRIBS)
+  stars = generate_star_field(star_seed, number_of_stars, star_field_extent);
+  //the star field never changes, build the hierarchy once and store stars in its order, so every leaf is a contiguous vertex range
+  std::vector<aabb> star_boxes(stars.size());
+  for (std::size_t i = 0; i < stars.size(); ++i)
   {
-      // check if buffer contains attribute
-      if (supported_attribute.flag & contained_attributes)
-      {
-          // write offset, explicit cast to prevent narrowing warning
-          star_model.offsets.insert(std::pair<model::attrib_flag_t, GLvoid*>{supported_attribute, (GLvoid*)uintptr_t(star_model.vertex_bytes)});
-          // move offset pointer forward
-          star_model.vertex_bytes += supported_attribute.size * supported_attribute.components;
-          // increase number of components
-          component_num += supported_attribute.components;
-      }
+      glm::fvec3 position{stars[i].x, stars[i].y, stars[i].z};
+      star_boxes[i] = aabb{position, position};
   }
-  // set number of vertice sin buffer
-  star_model.vertex_num = star_model.data.size() / component_num;
+  m_star_bvh.build(star_boxes, stars_per_leaf);
+  std::vector<star_point> sorted_stars(stars.size());
+  for (std::size_t i = 0; i < stars.size(); ++i)
+  {
+      sorted_stars[i] = stars[m_star_bvh.primitive_order()[i]];
+  }
+  stars.swap(sorted_stars);
   initializeGeometry();
   initializeShaderPrograms();
+  initializeScene();
+  initializeSurfaces();
+  initializeLights();
+  initializeAssets();
 }
 
-//cpu representations
-model_object planet_o{};
 //needed new model_object for stars
 model_object star{};
 
-//please find declaration of struct "planet" in framework/include/structs.hpp
-planet mercury_properties{mercury_model, planet_o, "Mercury",  0.3f, 0, 2.0f};
-planet venus_properties{venus_model, planet_o, "Venus", 0.4f, 1, 6.0f};
-planet earth_properties{earth_model, planet_o, "Earth", 0.5f, 2, 9.0f};
-planet mars_properties{mars_model, planet_o, "Mars", 0.3f, 3, 14.0f};
-planet jupiter_properties{jupiter_model, planet_o, "Jupiter", 1.6f, 4, 20.0f};
-planet saturn_properties{saturn_model, planet_o, "Saturn", 1.2f, 5, 30.0f};
-planet uranus_properties{uranus_model, planet_o, "Uranus", 0.8f, 6, 40.0f};
-planet neptune_properties{neptune_model, planet_o, "Neptune", 0.6f, 7, 50.0f};
-planet sun_properties{sun_model, planet_o, "Sun", 1.5f, 0, 0.0f};
-//speed and distance of the Moon is equal to the speed and distance of the Earth
-planet moon_properties{moon_model, planet_o, "Moon", 0.3f, 2, 9.0f};
-//appropriate container to store the planets with their properties
-planet properties[10] = {mercury_properties, venus_properties, earth_properties, mars_properties, jupiter_properties, saturn_properties, uranus_properties, neptune_properties, sun_properties, moon_properties};
-
-
-void ApplicationSolar::upload_planet_transforms(planet const& model) const
+//mesh handles of the bodies, a handle is the coarsest of consecutive levels of detail
+const std::uint32_t SPHERE_MESH = 0;
+
+//description of a body, only needed for initialization
+struct body_description
 {
-    std::string planet_name = model.name;
-    std::string moon = "Moon";
-    std::string sun = "Sun";
-    std::string earth = "Earth";
-    glm::fmat4 model_matrix_earth{};
-    
-    //we need to consider two "special" cases - Sun and Moon, which we identify by their names (3rd value in the struct)
-    if (planet_name.compare(sun) == 0)
+    char const* name;
+    //index of the orbited body, -1 for bodies that stay at the origin
+    int parent;
+    //scale factor for the sphere
+    float size;
+    //mass in gravity mode
+    float mass;
+    //distance from the parent, angular speed and starting angle
+    orbit motion;
+};
+
+//orbited bodies must come before their satellites
+body_description const solar_bodies[] = {
+    {"Sun", -1, 1.5f, 200.0f, {0.0f, 0.0f, 0.0f}},
+    {"Mercury", 0, 0.3f, 0.01f, {2.0f, 1.0f, 0.0f}},
+    {"Venus", 0, 0.4f, 0.1f, {6.0f, 1.0f, 1.0f}},
+    //far too heavy, otherwise the Sun would pull the Moon away at this distance
+    {"Earth", 0, 0.5f, 25.0f, {9.0f, 1.0f, 2.0f}},
+    {"Mars", 0, 0.3f, 0.02f, {14.0f, 1.0f, 3.0f}},
+    {"Jupiter", 0, 1.6f, 1.0f, {20.0f, 1.0f, 4.0f}},
+    {"Saturn", 0, 1.2f, 0.5f, {30.0f, 1.0f, 5.0f}},
+    {"Uranus", 0, 0.8f, 0.2f, {40.0f, 1.0f, 6.0f}},
+    {"Neptune", 0, 0.6f, 0.2f, {50.0f, 1.0f, 7.0f}},
+    //the Moon orbits the Earth, its distance is relative to it
+    {"Moon", 3, 0.3f, 0.001f, {1.5f, 4.0f, 2.0f}}
+};
+
+//asteroid belt between Mars and Jupiter, only simulated in gravity mode
+const std::size_t number_of_asteroids = 10000;
+const std::uint32_t asteroid_seed = 17;
+const float asteroid_mass = 1e-6f;
+
+//bodies at least this large hide others, smaller ones cover too few pixels to be worth rasterizing
+const float occluder_size = 1.0f;
+
+
+void ApplicationSolar::initializeScene()
+{
+    //surface 0 is plain white, the body surfaces follow in table order
+    std::uint32_t surface = 1;
+    for (auto const& body : solar_bodies)
+    {
+        std::uint8_t flags = BODY_DRAW;
+        //bodies without parent stay at the origin, their transform never changes
+        if (body.parent < 0)
+        {
+            flags |= BODY_STATIC;
+        }
+        if (body.size >= occluder_size)
+        {
+            flags |= BODY_OCCLUDER;
+        }
+        //the Sun holds the main light, it would only light itself from inside
+        if (body.parent < 0)
+        {
+            flags |= BODY_EMISSIVE;
+        }
+        m_bodies.add(m_scene, body.parent, body.motion, body.size, SPHERE_MESH, flags, surface++);
+    }
+    m_body_lods.assign(m_bodies.size(), 0);
+    //topology is built once from the initial bounds, afterwards only refitted
+    m_scene.update();
+    update_body_bounds();
+    m_body_bvh.build(m_body_boxes);
+    m_simulation_scene = m_scene;
+}
+
+//pack the surface textures of all bodies into one texture array, bodies without texture file stay white
+void ApplicationSolar::initializeSurfaces()
+{
+    //white texels leave the shading unchanged
+    pixel_data const white{std::vector<std::uint8_t>(4 * 4 * 4, 255), GL_RGBA, GL_UNSIGNED_BYTE, 4, 4};
+    m_surfaces.add(white);
+    for (auto const& body : solar_bodies)
     {
-        //Sun is a "static" object, it doesn't change its position(that's why translation using (0, 0, 0) vector) and doesn't rotate
-        model_matrix = glm::translate(model_matrix, glm::fvec3{0.0f, 0.0f, 0.0f});
+        std::string name{body.name};
+        std::transform(name.begin(), name.end(), name.begin(), [](char c) { return char(std::tolower(c)); });
+        std::string file_name = m_resource_path + "textures/" + name + ".png";
+        if (std::ifstream{file_name})
+        {
+            m_surfaces.add(texture_loader::file(file_name));
+        }
+        else
+        {
+            m_surfaces.add(white);
+        }
     }
-    else if (planet_name.compare(moon) == 0)
-    {
-        //Moon is spinning around Earth, that's why we have to rotate its model_matrix around Earth's model_matrix - we defined a variable for that, which is initial empty. But when we look at the container of planets, we see that Earth comes always first before Moon, so when we will be iterating the container as usual (for (int i=...)), model_matrix_earth will be always set before it comes to computing matrice for the Moon.
-        model_matrix = glm::rotate(model_matrix_earth, float(glfwGetTime() + model.speed), glm::fvec3{0.0f, 1.0f, 0.0f});
-        model_matrix = glm::translate(model_matrix, glm::fvec3{model.distance, 0.0f, 0.0f});
-        model_matrix = glm::rotate(model_matrix, float(glfwGetTime()*4.0f), glm::fvec3{0.0f, 1.0f, 1.0f});
-        //this translation is optional - it's only to make the Moon visible good enough
-        model_matrix = glm::translate(model_matrix, glm::fvec3{3.0f, 0.0f, 0.0f});
+    m_surfaces.build();
+    std::cout << "Surfaces: " << m_surfaces.size() << " in " << m_surfaces.layers() << " layers of "
+              << m_surfaces.layer_width() << "x" << m_surfaces.layer_height() << std::endl;
+    //nothing else uses textures, the array stays bound for every frame
+    glActiveTexture(GL_TEXTURE0 + SURFACE_TEXTURE_UNIT);
+    glBindTexture(m_surfaces.texture().target, m_surfaces.texture().handle);
+    m_cluster_ranges.bind(CLUSTER_RANGE_UNIT);
+    m_cluster_indices.bind(CLUSTER_INDEX_UNIT);
+    m_light_data.bind(LIGHT_UNIT);
+}
+
+//the Sun light stays in the center, the others circle random bodies just above their surface
+void ApplicationSolar::initializeLights()
+{
+    m_body_lights.push_back(body_light{0, orbit{0.0f, 0.0f, 0.0f}, 0.0f, glm::fvec3{1.0f, 0.95f, 0.85f}, sun_light_radius, sun_light_intensity});
+    const float pi = 3.14159265f;
+    for (std::size_t i = 0; i < number_of_body_lights; ++i)
+    {
+        //ten random numbers for every light
+        auto random = [i](std::uint32_t n) { return random_unit(light_seed, std::uint32_t(i * 10 + n)); };
+        std::uint32_t body = 1 + std::uint32_t(random(0) * float(m_bodies.size() - 1)) % std::uint32_t(m_bodies.size() - 1);
+        float scale = m_bodies.scales[body];
+        orbit motion{scale * (1.5f + random(1) * 1.5f), (random(2) < 0.5f ? -1.0f : 1.0f) * (0.5f + random(3) * 1.5f), random(4) * 2.0f * pi};
+        glm::fvec3 color{0.4f + 0.6f * random(5), 0.4f + 0.6f * random(6), 0.4f + 0.6f * random(7)};
+        m_body_lights.push_back(body_light{body, motion, (random(8) - 0.5f) * scale, color, scale * (2.0f + random(9) * 3.0f), 1.0f});
     }
-    else
+    m_lights.reserve(m_body_lights.size());
+}
+
+void ApplicationSolar::initializeAssets()
+{
+    asset_memory& memory = asset_memory::instance();
+    //occluders are rasterized from the cpu vertices every frame, the bounds used for picking and culling survive eviction
+    std::vector<bool> needed_on_cpu(m_mesh_models.size(), false);
+    for (std::size_t i = 0; i < m_bodies.size(); ++i)
+    {
+        if (m_bodies.flags[i] & BODY_OCCLUDER)
+        {
+            needed_on_cpu[m_bodies.meshes[i] + occluder_level] = true;
+        }
+    }
+    for (std::size_t i = 0; i < m_mesh_models.size(); ++i)
     {
-        //obviously, the planets are rotating around y-axis, that's why we put glm::fvec3{0.0f, 1.0f, 0.0f} as the last argument of the function. glfwGetTime() returns the value of the GLFW timer. Unless the timer has been set using glfwSetTime, the timer measures time elapsed since GLFW was initialized. And the greater the value of the second argument of the glm::rotate function, the slower the rotation.
-        model_matrix = glm::rotate(model_matrix, float(glfwGetTime() + model.speed), glm::fvec3{0.0f, 1.0f, 0.0f});
-        //we need to "move away" the planet from the Sun in the x-axis. The value for that is specified in the struct "planet".
-        model_matrix = glm::translate(model_matrix, glm::fvec3{model.distance, 0.0f, -1.0f});
-        if (planet_name.compare(earth) == 0)
+        asset_memory::handle asset = memory.track("mesh " + std::to_string(i), "model", m_mesh_models[i].cpu_bytes(), m_geometry.bytes(m_meshes[i]));
+        if (memory.evict_after_upload(needed_on_cpu[i]))
         {
-            model_matrix_earth = model_matrix;
+            m_mesh_models[i].release_cpu_copy();
+            memory.evicted(asset);
         }
+        m_assets.push_back(asset);
     }
-    //scaling the matrix comes as the last operation for each object in properties[]
-    model_matrix = glm::scale(model_matrix, glm::fvec3{model.size, model.size, model.size});
-    //additionally, we also compute the normal_matrix in this function - extra matrix for normal transformation to keep the planets orthogonal to surface
-    normal_matrix = glm::inverseTranspose(glm::inverse(m_view_transform) * model_matrix);
+
+    //the hierarchy is built and the vertex buffer uploaded, nothing reads the stars afterwards
+    asset_memory::handle star_asset = memory.track("star field", "model", stars.capacity() * sizeof(star_point), stars.size() * sizeof(star_point));
+    if (memory.evict_after_upload(false))
+    {
+        std::vector<star_point>{}.swap(stars);
+        memory.evicted(star_asset);
+    }
+    m_assets.push_back(star_asset);
+    //positions live in the simulation, the buffer only receives them
+    m_assets.push_back(memory.track("asteroids", "buffer", 0, sizeof(GLfloat) * 3 * number_of_asteroids));
+    memory.print(std::cout);
 }
 
-void ApplicationSolar::render() const
+//world space bounding boxes of all bodies around their bounding spheres
+void ApplicationSolar::update_body_bounds() const
 {
-    //bind shader to upload uniforms
-    glUseProgram(m_shaders.at("planet").handle);
-    
-    for (int i = 0; i<10; i++)
+    m_body_boxes.resize(m_bodies.size());
+    for (std::size_t i = 0; i < m_bodies.size(); ++i)
     {
-        upload_planet_transforms(properties[i]);
-        glUniformMatrix4fv(m_shaders.at("planet").u_locs.at("ModelMatrix"),
-                       1, GL_FALSE, glm::value_ptr(model_matrix));
-        glUniformMatrix4fv(m_shaders.at("planet").u_locs.at("NormalMatrix"),
-                       1, GL_FALSE, glm::value_ptr(normal_matrix));
-        // bind the VAO to draw
-        glBindVertexArray(properties[i].planet_object.vertex_AO);
-    
-        // draw bound vertex array using bound shader
-        glDrawElements(properties[i].planet_object.draw_mode, properties[i].planet_object.num_elements, model::INDEX.type, NULL);
-        //after drawing the element, the matrices must again be empty, otherwise we would generate further planets based on the previous calculations of these matrices.
-        model_matrix = {};
-        normal_matrix = {};
+        model const& mesh_model = m_mesh_models[m_bodies.meshes[i]];
+        glm::fvec3 center{m_scene.world(m_bodies.mesh_nodes[i]) * glm::fvec4{mesh_model.sphere_center, 1.0f}};
+        float radius = mesh_model.sphere_radius * m_bodies.scales[i];
+        m_body_boxes[i] = aabb{center - radius, center + radius};
     }
-    
-    // bind new shader
-    glUseProgram(m_shaders.at("star").handle);
-    // bind the VAO to draw
-    glBindVertexArray(star.vertex_AO);
-    glDrawArrays(gl::GL_POINTS, 0, star_model.vertex_num);
 }
 
-void ApplicationSolar::updateView()
+//level of detail of the visible bodies from their size on screen
+void ApplicationSolar::select_lods(glm::fvec3 const& eye) const
 {
-    // vertices are transformed in camera space, so camera transform must be inverted
-    glm::fmat4 view_matrix = glm::inverse(m_view_transform);
-    // upload matrix to gpu
-    glUseProgram(m_shaders.at("planet").handle);
-    glUniformMatrix4fv(m_shaders.at("planet").u_locs.at("ViewMatrix"),
-                           1, GL_FALSE, glm::value_ptr(view_matrix));
-    glUseProgram(m_shaders.at("star").handle);
-    glUniformMatrix4fv(m_shaders.at("star").u_locs.at("ViewMatrix"),
-                       1, GL_FALSE, glm::value_ptr(view_matrix));
+    for (std::uint32_t i : m_visible)
+    {
+        //boxes enclose the bounding spheres
+        aabb const& box = m_body_boxes[i];
+        glm::fvec3 center = (box.min + box.max) * 0.5f;
+        float radius = (box.max.x - box.min.x) * 0.5f;
+        float size = lod_selector::projected_size(m_view_projection, glm::length(center - eye), radius);
+        m_body_lods[i] = std::uint8_t(m_sphere_lods.select(size, m_body_lods[i]));
+    }
 }
 
-void ApplicationSolar::updateProjection()
+std::uint32_t ApplicationSolar::drawn_mesh(std::uint32_t body) const
 {
-  // upload matrix to gpu
-  glUseProgram(m_shaders.at("planet").handle);
-  glUniformMatrix4fv(m_shaders.at("planet").u_locs.at("ProjectionMatrix"),
-                     1, GL_FALSE, glm::value_ptr(m_view_projection));
-  glUseProgram(m_shaders.at("star").handle);
-  glUniformMatrix4fv(m_shaders.at("star").u_locs.at("ProjectionMatrix"),
-                       1, GL_FALSE, glm::value_ptr(m_view_projection));
+    return m_bodies.meshes[body] + m_body_lods[body];
 }
 
-// update uniform locations
-void ApplicationSolar::uploadUniforms()
+//world position of every light from its body, the shader works in view space
+void ApplicationSolar::update_lights(glm::fmat4 const& view_matrix, float time) const
 {
-    uploadUniforms_p();
-    uploadUniforms_s();
+    m_lights.resize(m_body_lights.size());
+    for (std::size_t i = 0; i < m_body_lights.size(); ++i)
+    {
+        body_light const& light = m_body_lights[i];
+        glm::fvec3 center{m_scene.world(m_bodies.orbit_nodes[light.body])[3]};
+        float angle = light.motion.phase + light.motion.angular_speed * time;
+        glm::fvec3 offset{std::cos(angle) * light.motion.radius, light.height, -std::sin(angle) * light.motion.radius};
+        m_lights[i] = point_light{glm::fvec3{view_matrix * glm::fvec4{center + offset, 1.0f}}, light.radius, light.color, light.intensity};
+    }
 }
 
-void ApplicationSolar::uploadUniforms_p()
+void ApplicationSolar::upload_clusters() const
 {
-    updateUniformLocations();
-    
-    // bind new shader
-    glUseProgram(m_shaders.at("planet").handle);
-    
-    updateView();
-    updateProjection();
+    m_clusters.assign(m_lights);
+    static_assert(sizeof(light_clusters::range) == 2 * sizeof(std::uint32_t), "ranges are read as two component texels");
+    m_cluster_ranges.update(m_clusters.ranges().data(), m_clusters.ranges().size() * sizeof(light_clusters::range));
+    m_cluster_indices.update(m_clusters.indices().data(), m_clusters.indices().size() * sizeof(std::uint32_t));
+    //two texels per light, position and radius followed by the scaled colour
+    frame_vector<glm::fvec4> light_texels{};
+    light_texels.reserve(m_lights.size() * 2);
+    for (point_light const& light : m_lights)
+    {
+        light_texels.push_back(glm::fvec4{light.position, light.radius});
+        light_texels.push_back(glm::fvec4{light.color * light.intensity, 0.0f});
+    }
+    m_light_data.update(light_texels.data(), light_texels.size() * sizeof(glm::fvec4));
 }
 
-void ApplicationSolar::uploadUniforms_s()
+void ApplicationSolar::update(double delta_time)
 {
-    updateUniformLocations();
-    
-    // bind new shader
-    glUseProgram(m_shaders.at("star").handle);
-    
-    updateView();
-    updateProjection();
+    m_last_sim_time = m_sim_time;
+    m_sim_time += delta_time;
+    if (m_gravity)
+    {
+        leapfrog_step(m_nbody, m_gravity_tree, m_gravity_settings, float(delta_time));
+    }
+}
+
+//fill the free snapshot, it is read by render once acquired
+void ApplicationSolar::publish()
+{
+    solar_snapshot& snapshot = m_snapshots.write_slot();
+    snapshot.view_transform = m_view_transform;
+    //blend between the last two simulation steps, so motion stays smooth at any frame rate
+    snapshot.time = float(m_last_sim_time + (m_sim_time - m_last_sim_time) * m_frame_alpha);
+    snapshot.gravity = m_gravity;
+    snapshot.occlusion_culling = m_occlusion_culling;
+    snapshot.picks = m_pick_requests;
+    if (m_gravity)
+    {
+        //simulated positions are shown as of the last step, the integrator state can not be blended
+        snapshot.positions.resize(m_nbody.size());
+        for (std::size_t i = 0; i < m_nbody.size(); ++i)
+        {
+            snapshot.positions[i] = glm::fvec3{m_nbody.x[i], m_nbody.y[i], m_nbody.z[i]};
+        }
+    }
+    m_snapshots.publish();
+}
+
+void ApplicationSolar::acquire()
+{
+    //without a new snapshot the last one is drawn again
+    if (m_snapshots.acquire())
+    {
+        // vertices are transformed in camera space, so camera transform must be inverted
+        glm::fmat4 view_matrix = glm::inverse(m_snapshots.read_slot().view_transform);
+        //only uploaded if the camera moved
+        m_shaders.at("planet").set_uniform("ViewMatrix", view_matrix);
+        m_shaders.at("star").set_uniform("ViewMatrix", view_matrix);
+    }
+}
+
+//render reads nothing the simulation thread writes
+bool ApplicationSolar::renders_snapshots() const
+{
+    return true;
+}
+
+//replace circular orbits by point masses starting from the current positions and orbital velocities
+void ApplicationSolar::start_gravity()
+{
+    update_orbits(m_bodies, float(m_sim_time), m_simulation_scene);
+    m_simulation_scene.update();
+    gather_positions(m_bodies, m_simulation_scene);
+
+    m_nbody = nbody_system{};
+    for (std::size_t i = 0; i < m_bodies.size(); ++i)
+    {
+        body_description const& body = solar_bodies[i];
+        glm::fvec3 velocity{0.0f};
+        if (body.parent >= 0)
+        {
+            std::size_t parent = std::size_t(body.parent);
+            glm::fvec3 offset = m_bodies.positions[i] - m_bodies.positions[parent];
+            float distance = glm::length(offset);
+            //circular orbit in the same direction as the rotation around the y-axis
+            float speed = std::sqrt(m_gravity_settings.gravity * solar_bodies[parent].mass / distance);
+            glm::fvec3 direction = glm::cross(glm::fvec3{0.0f, 1.0f, 0.0f}, offset) / distance;
+            velocity = glm::fvec3{m_nbody.vx[parent], m_nbody.vy[parent], m_nbody.vz[parent]} + direction * speed;
+        }
+        m_nbody.add(m_bodies.positions[i], velocity, body.mass);
+    }
+    glm::fvec3 sun_position{m_nbody.x[0], m_nbody.y[0], m_nbody.z[0]};
+    glm::fvec3 sun_velocity{m_nbody.vx[0], m_nbody.vy[0], m_nbody.vz[0]};
+    add_ring(m_nbody, asteroid_seed, number_of_asteroids, sun_position, sun_velocity, solar_bodies[0].mass,
+             15.5f, 17.5f, 0.3f, asteroid_mass, m_gravity_settings.gravity);
+
+    //remove the momentum of the whole system, so it does not drift away
+    glm::fvec3 momentum{0.0f};
+    float total_mass = 0.0f;
+    for (std::size_t i = 0; i < m_nbody.size(); ++i)
+    {
+        momentum += glm::fvec3{m_nbody.vx[i], m_nbody.vy[i], m_nbody.vz[i]} * m_nbody.mass[i];
+        total_mass += m_nbody.mass[i];
+    }
+    glm::fvec3 drift = momentum / total_mass;
+    for (std::size_t i = 0; i < m_nbody.size(); ++i)
+    {
+        m_nbody.vx[i] -= drift.x;
+        m_nbody.vy[i] -= drift.y;
+        m_nbody.vz[i] -= drift.z;
+    }
+
+    //the integrator expects accelerations of the current positions
+    m_gravity_tree.build(m_nbody);
+    m_gravity_tree.accelerate(m_nbody, m_gravity_settings);
 }
 
+//write simulated positions of the snapshot into the scene graph and the asteroid buffer
+void ApplicationSolar::apply_gravity_positions() const
+{
+    std::vector<glm::fvec3> const& positions = m_snapshots.read_slot().positions;
+    for (std::size_t i = 0; i < m_bodies.size(); ++i)
+    {
+        glm::fvec3 position = positions[i];
+        //satellite nodes are attached to their parent, so only the offset is stored
+        int parent = solar_bodies[i].parent;
+        if (parent >= 0)
+        {
+            position -= positions[std::size_t(parent)];
+        }
+        m_scene.set_local(m_bodies.orbit_nodes[i], glm::translate(glm::fmat4{}, position));
+    }
+
+    //asteroids follow the bodies, tightly packed like the buffer expects
+    static_assert(sizeof(glm::fvec3) == asteroid_layout::stride, "asteroid positions must be packed");
+    glBindBuffer(GL_ARRAY_BUFFER, m_asteroids.vertex_BO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::fvec3) * number_of_asteroids, positions.data() + m_bodies.size());
+}
+
+//rasterize the visible occluders on the cpu and drop bodies completely behind them
+void ApplicationSolar::cull_occluded() const
+{
+    m_occlusion.begin(m_view_projection * glm::inverse(m_snapshots.read_slot().view_transform));
+    for (std::uint32_t i : m_visible)
+    {
+        if (m_bodies.flags[i] & BODY_OCCLUDER)
+        {
+            model const& mesh_model = m_mesh_models[m_bodies.meshes[i] + occluder_level];
+            //positions are the first attribute of every vertex
+            m_occlusion.add_occluder(m_scene.world(m_bodies.mesh_nodes[i]), mesh_model.data.data(), mesh_model.vertex_num,
+                                     std::size_t(mesh_model.vertex_bytes) / sizeof(GLfloat), mesh_model.indices.data(), mesh_model.indices.size());
+        }
+    }
+    m_occlusion.finish();
+    m_occlusion.cull(m_body_boxes, m_visible);
+}
+
+void ApplicationSolar::render() const
+{
+    solar_snapshot const& snapshot = m_snapshots.read_slot();
+    //only changed nodes and their children are recomputed, the scale nodes only when their orbit moved
+    if (snapshot.gravity)
+    {
+        apply_gravity_positions();
+    }
+    else
+    {
+        //orbits skip static bodies, move them back to where they started
+        if (m_rendered_gravity)
+        {
+            for (std::size_t i = 0; i < m_bodies.size(); ++i)
+            {
+                if (m_bodies.flags[i] & BODY_STATIC)
+                {
+                    m_scene.set_local(m_bodies.orbit_nodes[i], glm::fmat4{});
+                }
+            }
+        }
+        update_orbits(m_bodies, snapshot.time, m_scene);
+    }
+    m_rendered_gravity = snapshot.gravity;
+    m_scene.update();
+    //lights follow the bodies, every fragment only loops over the lists of its cluster
+    update_lights(glm::inverse(snapshot.view_transform), snapshot.time);
+    upload_clusters();
+
+    //m_view_projection only holds the projection
+    frustum view_frustum = extract_frustum(m_view_projection * glm::inverse(snapshot.view_transform));
+    //bodies move, so the hierarchy is refitted every frame
+    update_body_bounds();
+    m_body_bvh.refit(m_body_boxes);
+    if (snapshot.picks != m_picks_handled)
+    {
+        m_picks_handled = snapshot.picks;
+        pick_body();
+    }
+    m_visible.clear();
+    m_body_bvh.query_frustum(view_frustum, m_visible);
 
+    //visible bodies grouped by mesh, every group is one instanced draw
+    m_visible.erase(std::remove_if(m_visible.begin(), m_visible.end(), [this](std::uint32_t i)
+    {
+        return !(m_bodies.flags[i] & BODY_DRAW);
+    }), m_visible.end());
+    if (snapshot.occlusion_culling)
+    {
+        cull_occluded();
+    }
+    glm::fvec3 eye{snapshot.view_transform[3]};
+    select_lods(eye);
+    //the instance stream only has room for a fixed number of bodies, keep the nearest
+    if (m_visible.size() > max_body_instances)
+    {
+        std::nth_element(m_visible.begin(), m_visible.begin() + std::ptrdiff_t(max_body_instances), m_visible.end(), [&](std::uint32_t a, std::uint32_t b)
+        {
+            glm::fvec3 offset_a = (m_body_boxes[a].min + m_body_boxes[a].max) * 0.5f - eye;
+            glm::fvec3 offset_b = (m_body_boxes[b].min + m_body_boxes[b].max) * 0.5f - eye;
+            return glm::dot(offset_a, offset_a) < glm::dot(offset_b, offset_b);
+        });
+        m_visible.resize(max_body_instances);
+    }
+    std::sort(m_visible.begin(), m_visible.end(), [this](std::uint32_t a, std::uint32_t b)
+    {
+        return drawn_mesh(a) < drawn_mesh(b) || (drawn_mesh(a) == drawn_mesh(b) && a < b);
+    });
+
+    //visible bodies of one mesh in batches, every batch is one instanced draw with its own part of the stream buffer
+    struct body_batch
+    {
+        std::size_t first;
+        std::size_t last;
+        std::uint32_t mesh;
+        stream_buffer::allocation instances;
+    };
+    m_instance_stream.begin_frame();
+    frame_vector<body_batch> batches{};
+    std::size_t group_start = 0;
+    while (group_start < m_visible.size())
+    {
+        std::uint32_t mesh_index = drawn_mesh(m_visible[group_start]);
+        std::size_t group_end = group_start;
+        while (group_end < m_visible.size() && drawn_mesh(m_visible[group_end]) == mesh_index
+               && group_end - group_start < instances_per_batch)
+        {
+            ++group_end;
+        }
+        //the stream buffer is not thread safe, reserve all parts before recording
+        //attributes only need the alignment of floats, so batches are packed without padding and max_body_instances always fit
+        batches.push_back(body_batch{group_start, group_end, mesh_index,
+                                     m_instance_stream.allocate(sizeof(body_instance) * (group_end - group_start), alignof(body_instance))});
+        group_start = group_end;
+    }
+
+    m_commands.clear();
+    command_buffer& planet_setup = m_commands.append();
+    planet_setup.use_program(m_shaders.at("planet").handle);
+    m_shaders.at("planet").record_uniforms(planet_setup);
+    //all meshes are in the same buffers, one vertex array for the whole scene
+    planet_setup.bind_vertex_array(m_geometry.vertex_array());
+    planet_setup.bind_buffer(command::ARRAY_BUFFER, m_instance_stream.handle());
+    //workers write matrices straight into the mapped buffer and record the draws
+    record_parallel(m_commands, 0, batches.size(), batches_per_job, [&](std::size_t first, std::size_t last, command_buffer& commands)
+    {
+        for (std::size_t b = first; b < last; ++b)
+        {
+            body_batch const& batch = batches[b];
+            body_instance* instance = static_cast<body_instance*>(batch.instances.data);
+            for (std::size_t v = batch.first; v < batch.last; ++v, ++instance)
+            {
+                std::size_t node = m_bodies.mesh_nodes[m_visible[v]];
+                instance->model_matrix = m_scene.world(node);
+                instance->normal_matrix = m_scene.normal(node);
+                texture_atlas::surface const& surface = m_surfaces.get(m_bodies.surfaces[m_visible[v]]);
+                instance->surface_rect = glm::fvec4{surface.offset, surface.scale};
+                instance->surface_layer = surface.layer;
+                instance->emission = (m_bodies.flags[m_visible[v]] & BODY_EMISSIVE) ? 1.0f : 0.0f;
+            }
+            // instance attributes read this batch's part of the stream buffer
+            //surfaces of all bodies are in the bound texture array, so the batch needs no texture switch
+            record_vertex_attributes<body_instance_layout>(commands, INSTANCE_LOCATION, std::uint64_t(batch.instances.offset));
+            geometry_arena::mesh_range const& mesh = m_meshes[batch.mesh];
+            commands.draw_indexed(command::TRIANGLES, mesh.index_count, mesh.first_index, mesh.base_vertex, GLsizei(batch.last - batch.first));
+        }
+    });
+    m_instance_stream.end_writes();
+
+    command_buffer& background = m_commands.append();
+    background.use_program(m_shaders.at("star").handle);
+    m_shaders.at("star").record_uniforms(background);
+    // only draw leaves of the star hierarchy that are in view
+    m_star_ranges.clear();
+    m_star_bvh.query_frustum(view_frustum, m_star_ranges);
+    //draw lists only live for this frame
+    frame_vector<GLint> star_draw_first{};
+    frame_vector<GLsizei> star_draw_count{};
+    star_draw_first.reserve(m_star_ranges.size());
+    star_draw_count.reserve(m_star_ranges.size());
+    for (bvh::range const& star_range : m_star_ranges)
+    {
+        star_draw_first.push_back(GLint(star_range.first));
+        star_draw_count.push_back(GLsizei(star_range.count));
+    }
+    if (!star_draw_first.empty())
+    {
+        // bind the VAO to draw
+        background.bind_vertex_array(star.vertex_AO);
+        background.multi_draw_arrays(command::POINTS, star_draw_first.data(), star_draw_count.data(), std::uint32_t(star_draw_first.size()));
+    }
+
+    if (snapshot.gravity)
+    {
+        //asteroids have no colour attribute, use a constant one
+        background.bind_vertex_array(m_asteroids.vertex_AO);
+        background.attribute_constant(1, glm::fvec4{0.7f, 0.6f, 0.5f, 1.0f});
+        background.draw_arrays(command::POINTS, 0, GLsizei(number_of_asteroids));
+    }
+
+    //only the replay of the recorded commands needs the gl thread
+    gl_commands::execute(m_commands);
+    m_instance_stream.end_frame();
+}
+
+void ApplicationSolar::updateProjection()
+{
+  //uploaded before the next draw with the programs
+  m_shaders.at("planet").set_uniform("ProjectionMatrix", m_view_projection);
+  m_shaders.at("star").set_uniform("ProjectionMatrix", m_view_projection);
+  //cluster bounds depend on the projection only, they are set up once the launcher passed the real one
+  if (!m_projection_set)
+  {
+      return;
+  }
+  m_clusters.set_projection(m_view_projection);
+  glm::fvec2 depth_mapping = m_clusters.depth_mapping();
+  m_shaders.at("planet").set_uniform("ClusterGrid", glm::fvec4{m_clusters.grid(), ambient_light});
+  m_shaders.at("planet").set_uniform("ClusterDepth", glm::fvec4{depth_mapping, 0.0f, 0.0f});
+}
+
+// update uniform locations
+void ApplicationSolar::uploadUniforms()
+{
+    //locations of all programs at once, this also marks their values for upload
+    updateUniformLocations();
+    updateProjection();
+    //samplers keep their units until the program is linked again
+    GLuint planet = m_shaders.at("planet").handle;
+    glUseProgram(planet);
+    glUniform1i(utils::glGetUniformLocation(planet, "Surfaces"), GLint(SURFACE_TEXTURE_UNIT));
+    glUniform1i(utils::glGetUniformLocation(planet, "ClusterRanges"), GLint(CLUSTER_RANGE_UNIT));
+    glUniform1i(utils::glGetUniformLocation(planet, "ClusterIndices"), GLint(CLUSTER_INDEX_UNIT));
+    glUniform1i(utils::glGetUniformLocation(planet, "Lights"), GLint(LIGHT_UNIT));
+    glUseProgram(0);
+}
 
 // handle key input
 // W,S - depth
@@ -289,20 +802,46 @@ void ApplicationSolar::keyCallback(int key, int scancode, int action, int mods)
   {
       m_view_transform = glm::rotate(m_view_transform, -0.1f, glm::fvec3{0.0f, 0.1f, 0.0f});
   }
-  else
+  //switch between circular orbits and gravity simulation
+  else if (key == GLFW_KEY_G && action == GLFW_PRESS)
   {
-      //do nothing
-      return;
+      m_gravity = !m_gravity;
+      if (m_gravity)
+      {
+          start_gravity();
+      }
+  }
+  //switch occlusion culling, for comparing frame times
+  else if (key == GLFW_KEY_O && action == GLFW_PRESS)
+  {
+      m_occlusion_culling = !m_occlusion_culling;
+      std::cout << "Occlusion culling " << (m_occlusion_culling ? "on" : "off") << std::endl;
+  }
+  //pick the body in the center of the view
+  else if (key == GLFW_KEY_P && action == GLFW_PRESS)
+  {
+      ++m_pick_requests;
   }
-  //update view matrix
-  updateView();
+}
+
+//cast a ray along the viewing direction and print the first body it hits
+void ApplicationSolar::pick_body() const
+{
+    glm::fmat4 const& view_transform = m_snapshots.read_slot().view_transform;
+    glm::fvec3 origin{view_transform[3]};
+    glm::fvec3 direction{-view_transform[2]};
+    float distance = 0.0f;
+    int body = m_body_bvh.raycast(origin, glm::normalize(direction), distance);
+    if (body >= 0)
+    {
+        std::cout << "Picked " << solar_bodies[body].name << " at distance " << distance << std::endl;
+    }
 }
 
 void ApplicationSolar::mouseScrollCallback(double x, double y)
 {
     //scrolling changes the depth
     m_view_transform = glm::translate(m_view_transform, glm::fvec3{0.0f, 0.0f, y});
-    updateView();
 }
 
 // load shader programs
@@ -314,10 +853,10 @@ void ApplicationSolar::initializeShaderPrograms()
     m_shaders.emplace("star", shader_program{m_resource_path + "shaders/stars.vert",
         m_resource_path + "shaders/stars.frag"});
   // request uniform locations for shader program
-  m_shaders.at("planet").u_locs["NormalMatrix"] = -1;
-  m_shaders.at("planet").u_locs["ModelMatrix"] = -1;
   m_shaders.at("planet").u_locs["ViewMatrix"] = -1;
   m_shaders.at("planet").u_locs["ProjectionMatrix"] = -1;
+  m_shaders.at("planet").u_locs["ClusterGrid"] = -1;
+  m_shaders.at("planet").u_locs["ClusterDepth"] = -1;
   m_shaders.at("star").u_locs["ViewMatrix"] = -1;
   m_shaders.at("star").u_locs["ProjectionMatrix"] = -1;
 }
@@ -325,77 +864,40 @@ void ApplicationSolar::initializeShaderPrograms()
 // load models
 void ApplicationSolar::initializeGeometry()
 {
-    for (int i=0; i<10; i++)
-    {
-        properties[i].planet_model = model_loader::obj(m_resource_path + "models/sphere.obj", model::NORMAL);
-        
-        // generate vertex array object
-        glGenVertexArrays(1, &properties[i].planet_object.vertex_AO);
-        // bind the array for attaching buffers
-        glBindVertexArray(properties[i].planet_object.vertex_AO);
-        
-        // generate generic buffer
-        glGenBuffers(1, &properties[i].planet_object.vertex_BO);
-        // bind this as an vertex array buffer containing all attributes
-        glBindBuffer(GL_ARRAY_BUFFER, properties[i].planet_object.vertex_BO);
-        // configure currently bound array buffer
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * properties[i].planet_model.data.size(), properties[i].planet_model.data.data(), GL_STATIC_DRAW);
-        
-        // activate first attribute on gpu
-        glEnableVertexAttribArray(0);
-        // first attribute is 3 floats with no offset & stride
-        glVertexAttribPointer(0, model::POSITION.components, model::POSITION.type, GL_FALSE, properties[i].planet_model.vertex_bytes, properties[i].planet_model.offsets[model::POSITION]);
-        // activate second attribute on gpu
-        glEnableVertexAttribArray(1);
-        // second attribute is 3 floats with no offset & stride
-        glVertexAttribPointer(1, model::NORMAL.components, model::NORMAL.type, GL_FALSE, properties[i].planet_model.vertex_bytes, properties[i].planet_model.offsets[model::NORMAL]);
-        
-        // generate generic buffer
-        glGenBuffers(1, &properties[i].planet_object.element_BO);
-        // bind this as an vertex array buffer containing all attributes
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, properties[i].planet_object.element_BO);
-        // configure currently bound array buffer
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, model::INDEX.size * properties[i].planet_model.indices.size(), properties[i].planet_model.indices.data(), GL_STATIC_DRAW);
-        
-        // store type of primitive to draw
-        properties[i].planet_object.draw_mode = GL_TRIANGLES;
-        // transfer number of indices to model object
-        properties[i].planet_object.num_elements = GLsizei(properties[i].planet_model.indices.size());
+    //all bodies share one sphere, its levels are generated once
+    for (unsigned subdivisions : sphere_subdivisions)
+    {
+        m_mesh_models.push_back(cube_sphere(subdivisions, body_mesh_layout::flags));
     }
-    
-    // generate vertex array object
-    glGenVertexArrays(1, &star.vertex_AO);
-    // bind the array for attaching buffers
-    glBindVertexArray(star.vertex_AO);
-    
-    // generate generic buffer
-    glGenBuffers(1, &star.vertex_BO);
-    // bind this as an vertex array buffer containing all attributes
-    glBindBuffer(GL_ARRAY_BUFFER, star.vertex_BO);
-    // configure currently bound array buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * star_model.data.size(), star_model.data.data(), GL_STATIC_DRAW);
-    
-    // activate first attribute on gpu
-    glEnableVertexAttribArray(0);
-    // first attribute is 3 floats with no offset & stride
-    glVertexAttribPointer(0, model::POSITION.components, model::POSITION.type, GL_FALSE, star_model.vertex_bytes, star_model.offsets[model::POSITION]);
-    // activate second attribute on gpu
-    glEnableVertexAttribArray(1);
-    // second attribute is 3 floats with no offset & stride
-    glVertexAttribPointer(1, model::NORMAL.components, model::NORMAL.type, GL_FALSE, star_model.vertex_bytes, star_model.offsets[model::NORMAL]);
+
+    for (model const& mesh_model : m_mesh_models)
+    {
+        m_meshes.push_back(m_geometry.add(mesh_model));
+    }
+    m_geometry.print_usage(std::cout);
+
+    // instance attributes advance once per instance, their pointers are set when drawing
+    glBindVertexArray(m_geometry.vertex_array());
+    enable_vertex_attributes<body_instance_layout>(INSTANCE_LOCATION, 1);
+
+    // position, then colour and brightness as 4 normalized bytes
+    star = make_vertex_array<star_layout>(stars.data(), stars.size(), GL_POINTS);
+    // asteroid positions are rewritten every frame in gravity mode
+    m_asteroids = make_vertex_array<asteroid_layout, glm::fvec3>(nullptr, number_of_asteroids, GL_POINTS, GL_STREAM_DRAW);
 }
 
 ApplicationSolar::~ApplicationSolar()
 {
-    for (int i=0; i<10; i++)
+    for (asset_memory::handle asset : m_assets)
     {
-        glDeleteBuffers(1, &properties[i].planet_object.vertex_BO);
-        glDeleteBuffers(1, &properties[i].planet_object.element_BO);
-        glDeleteVertexArrays(1, &properties[i].planet_object.vertex_AO);
+        asset_memory::instance().untrack(asset);
     }
+    glDeleteBuffers(1, &m_asteroids.vertex_BO);
+    glDeleteVertexArrays(1, &m_asteroids.vertex_AO);
 }
 
-// exe entry point
+// exe entry point, excluded when linked into the benchmark
+#ifndef SOLAR_NO_MAIN
 int main(int argc, char* argv[])
 {
   Launcher::run<ApplicationSolar>(argc, argv);
@@ -409,4 +911,5 @@ int main(int argc, char* argv[])
       //model_matrix = {};
       //normal_matrix = {};
   //}
-}
\ No newline at end of file
+}
+#endif
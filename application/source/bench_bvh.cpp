@@ -0,0 +1,165 @@
+#include "benchmark.hpp"
+#include "bvh.hpp"
+#include "star_field.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// small boxes in a cube around the origin, like the stars and the asteroid belt
+std::vector<aabb> scatter_boxes(std::size_t count) {
+  std::vector<aabb> boxes(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    std::uint32_t counter = std::uint32_t(i * 3);
+    glm::fvec3 center{random_unit(13, counter) * 200.0f - 100.0f, random_unit(13, counter + 1) * 200.0f - 100.0f, random_unit(13, counter + 2) * 200.0f - 100.0f};
+    boxes[i] = aabb{center - 0.2f, center + 0.2f};
+  }
+  return boxes;
+}
+
+// query point of the given number, spread over the same cube
+glm::fvec3 query_point(std::uint32_t query) {
+  return glm::fvec3{random_unit(17, query * 3) * 200.0f - 100.0f, random_unit(17, query * 3 + 1) * 200.0f - 100.0f, random_unit(17, query * 3 + 2) * 200.0f - 100.0f};
+}
+
+// usage: bench_bvh [--max-boxes <n>] [--queries <n>] [--radius <r>] [--report <file>]
+// times build, refit and all query types against a linear scan over the same boxes
+int main(int argc, char* argv[]) {
+  std::string report_path{};
+  std::size_t max_boxes = 1000000;
+  unsigned queries = 1000;
+  float radius = 5.0f;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if (arg == "--max-boxes" && i + 1 < argc) {
+      max_boxes = std::max(std::size_t(1), std::size_t(std::stoul(argv[++i])));
+    }
+    else if (arg == "--queries" && i + 1 < argc) {
+      queries = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--radius" && i + 1 < argc) {
+      radius = std::stof(argv[++i]);
+    }
+    else if (arg == "--report" && i + 1 < argc) {
+      report_path = argv[++i];
+    }
+  }
+
+  // same projection as the launcher for a 16:9 window, looking from the edge of the cube into it
+  glm::fmat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+  frustum view_frustum = extract_frustum(projection * glm::lookAt(glm::fvec3{0.0f, 0.0f, 100.0f}, glm::fvec3{0.0f}, glm::fvec3{0.0f, 1.0f, 0.0f}));
+
+  std::ofstream file_out{};
+  if (!report_path.empty()) {
+    file_out.open(report_path);
+  }
+  benchmark::json_writer json{file_out.is_open() ? file_out : std::cout};
+  json.begin_object();
+  json.key("queries").value(queries);
+  json.key("radius").value(double(radius));
+  json.key("results").begin_array();
+
+  for (std::size_t count = 1000; ; count = std::min(count * 10, max_boxes)) {
+    std::vector<aabb> boxes = scatter_boxes(count);
+    bvh tree{};
+    double start = benchmark::now();
+    tree.build(boxes);
+    double build_seconds = benchmark::now() - start;
+    start = benchmark::now();
+    tree.refit(boxes);
+    double refit_seconds = benchmark::now() - start;
+
+    // frustum queries repeat the same view, the first fills the result lists so later ones do not allocate
+    std::vector<std::uint32_t> result{};
+    std::vector<bvh::range> ranges{};
+    tree.query_frustum(view_frustum, result);
+    start = benchmark::now();
+    for (unsigned query = 0; query < queries; ++query) {
+      result.clear();
+      tree.query_frustum(view_frustum, result);
+    }
+    double frustum_seconds = benchmark::now() - start;
+    std::size_t frustum_hits = result.size();
+    start = benchmark::now();
+    for (unsigned query = 0; query < queries; ++query) {
+      ranges.clear();
+      tree.query_frustum(view_frustum, ranges);
+    }
+    double range_seconds = benchmark::now() - start;
+
+    // the linear scan tests all boxes in the batches the bvh uses for its leaves
+    bounding_boxes linear_boxes{};
+    linear_boxes.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      linear_boxes.set(i, boxes[i].min, boxes[i].max);
+    }
+    start = benchmark::now();
+    for (unsigned query = 0; query < queries; ++query) {
+      result.clear();
+      cull_boxes(view_frustum, linear_boxes, 0, count, result);
+    }
+    double linear_frustum_seconds = benchmark::now() - start;
+
+    std::size_t sphere_hits = 0;
+    start = benchmark::now();
+    for (std::uint32_t query = 0; query < queries; ++query) {
+      result.clear();
+      tree.query_sphere(query_point(query), radius, result);
+      sphere_hits += result.size();
+    }
+    double sphere_seconds = benchmark::now() - start;
+
+    // checksum keeps the queries from being optimized away and both searches must agree on it
+    std::size_t nearest_sum = 0;
+    start = benchmark::now();
+    for (std::uint32_t query = 0; query < queries; ++query) {
+      nearest_sum += std::size_t(tree.nearest(query_point(query)));
+    }
+    double nearest_seconds = benchmark::now() - start;
+
+    std::size_t linear_nearest_sum = 0;
+    start = benchmark::now();
+    for (std::uint32_t query = 0; query < queries; ++query) {
+      glm::fvec3 point = query_point(query);
+      float best_squared = 1e30f;
+      std::size_t best = 0;
+      for (std::size_t i = 0; i < count; ++i) {
+        glm::fvec3 offset = glm::max(glm::max(boxes[i].min - point, point - boxes[i].max), glm::fvec3{0.0f});
+        float squared = glm::dot(offset, offset);
+        if (squared < best_squared) {
+          best_squared = squared;
+          best = i;
+        }
+      }
+      linear_nearest_sum += best;
+    }
+    double linear_nearest_seconds = benchmark::now() - start;
+
+    json.begin_object();
+    json.key("boxes").value(count);
+    json.key("nodes").value(tree.node_count());
+    json.key("build_ms").value(build_seconds * 1000.0);
+    json.key("refit_ms").value(refit_seconds * 1000.0);
+    json.key("frustum_us").value(frustum_seconds / double(queries) * 1e6);
+    json.key("frustum_ranges_us").value(range_seconds / double(queries) * 1e6);
+    json.key("linear_frustum_us").value(linear_frustum_seconds / double(queries) * 1e6);
+    json.key("frustum_hits").value(frustum_hits);
+    json.key("ranges").value(ranges.size());
+    json.key("sphere_us").value(sphere_seconds / double(queries) * 1e6);
+    json.key("sphere_hits_per_query").value(double(sphere_hits) / double(queries));
+    json.key("nearest_us").value(nearest_seconds / double(queries) * 1e6);
+    json.key("linear_nearest_us").value(linear_nearest_seconds / double(queries) * 1e6);
+    json.key("nearest_matches_linear").value(nearest_sum == linear_nearest_sum);
+    json.end_object();
+    if (count >= max_boxes) {
+      break;
+    }
+  }
+
+  json.end_array();
+  json.end_object();
+}
@@ -0,0 +1,109 @@
+#include "benchmark.hpp"
+#include "light_clusters.hpp"
+#include "star_field.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// point lights scattered in front of the camera, some reaching past the frustum
+std::vector<point_light> scatter_lights(std::size_t count) {
+  std::vector<point_light> lights(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    std::uint32_t counter = std::uint32_t(i * 5);
+    glm::fvec3 position{random_unit(11, counter) * 120.0f - 60.0f, random_unit(11, counter + 1) * 70.0f - 35.0f, -random_unit(11, counter + 2) * 100.0f};
+    lights[i] = point_light{position, 0.5f + random_unit(11, counter + 3) * 4.5f, glm::fvec3{1.0f}, 1.0f};
+  }
+  return lights;
+}
+
+// usage: bench_clusters [--lights <n>] [--tiles <x>x<y>] [--slices <n>] [--frames <n>] [--max-threads <n>] [--report <file>]
+int main(int argc, char* argv[]) {
+  std::string report_path{};
+  std::size_t max_lights = 4096;
+  unsigned tiles_x = 16;
+  unsigned tiles_y = 9;
+  unsigned slices = 24;
+  unsigned frames = 100;
+  unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if (arg == "--lights" && i + 1 < argc) {
+      max_lights = std::max(std::size_t(1), std::size_t(std::stoul(argv[++i])));
+    }
+    else if (arg == "--tiles" && i + 1 < argc) {
+      std::string tiles{argv[++i]};
+      std::size_t separator = tiles.find('x');
+      if (separator != std::string::npos) {
+        tiles_x = std::max(1u, unsigned(std::stoul(tiles.substr(0, separator))));
+        tiles_y = std::max(1u, unsigned(std::stoul(tiles.substr(separator + 1))));
+      }
+    }
+    else if (arg == "--slices" && i + 1 < argc) {
+      slices = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--frames" && i + 1 < argc) {
+      frames = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--max-threads" && i + 1 < argc) {
+      max_threads = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--report" && i + 1 < argc) {
+      report_path = argv[++i];
+    }
+  }
+
+  // same projection as the launcher for a 16:9 window
+  glm::fmat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+  light_clusters clusters{tiles_x, tiles_y, slices};
+  clusters.set_projection(projection);
+
+  std::ofstream file_out{};
+  if (!report_path.empty()) {
+    file_out.open(report_path);
+  }
+  benchmark::json_writer json{file_out.is_open() ? file_out : std::cout};
+  json.begin_object();
+  json.key("frames").value(frames);
+  json.key("clusters").value(clusters.cluster_count());
+  json.key("hardware_threads").value(std::thread::hardware_concurrency());
+  json.key("results").begin_array();
+
+  std::vector<unsigned> thread_counts{};
+  for (unsigned threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  for (std::size_t light_count = 64; ; light_count = std::min(light_count * 4, max_lights)) {
+    std::vector<point_light> lights = scatter_lights(light_count);
+    for (unsigned threads : thread_counts) {
+      // first assignment grows the lists, it is not measured
+      clusters.assign(lights, threads);
+      double start = benchmark::now();
+      for (unsigned frame = 0; frame < frames; ++frame) {
+        clusters.assign(lights, threads);
+      }
+      double seconds = benchmark::now() - start;
+
+      json.begin_object();
+      json.key("lights").value(light_count);
+      json.key("threads").value(threads);
+      json.key("assign_ms").value(seconds / double(frames) * 1000.0);
+      json.key("indices").value(clusters.indices().size());
+      json.key("max_per_cluster").value(clusters.max_lights_per_cluster());
+      json.end_object();
+    }
+    if (light_count >= max_lights) {
+      break;
+    }
+  }
+
+  json.end_array();
+  json.end_object();
+}
@@ -0,0 +1,271 @@
+#include "benchmark.hpp"
+#include "model_loader.hpp"
+#include "texture_loader.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// count heap allocations of the whole process
+std::atomic<std::size_t> allocation_count{0};
+std::atomic<std::size_t> allocation_bytes{0};
+
+void* operator new(std::size_t size) {
+  ++allocation_count;
+  allocation_bytes += size;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  operator delete(ptr);
+}
+
+// sized deallocation, used instead of the unsized versions when the compiler knows the size
+void operator delete(void* ptr, std::size_t) noexcept {
+  operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  operator delete(ptr);
+}
+
+// result of repeated execution of one loader call
+struct measurement {
+  double best_seconds;
+  double average_seconds;
+  // per run
+  std::size_t allocations;
+  std::size_t allocated_bytes;
+  // growth of the process peak resident set size, 0 if an earlier loader already needed more
+  std::size_t peak_rss_increase;
+};
+
+template<typename F>
+measurement measure(unsigned repetitions, F const& function) {
+  measurement result{1e300, 0.0, 0, 0, 0};
+  allocation_count = 0;
+  allocation_bytes = 0;
+  std::size_t start_rss = benchmark::peak_rss();
+  for (unsigned i = 0; i < repetitions; ++i) {
+    double start = benchmark::now();
+    function();
+    double duration = benchmark::now() - start;
+    result.best_seconds = std::min(result.best_seconds, duration);
+    result.average_seconds += duration / double(repetitions);
+  }
+  result.allocations = allocation_count / repetitions;
+  result.allocated_bytes = allocation_bytes / repetitions;
+  result.peak_rss_increase = benchmark::peak_rss() - start_rss;
+  return result;
+}
+
+std::size_t file_size(std::string const& path) {
+  std::ifstream file_in{path, std::ios::binary | std::ios::ate};
+  return std::size_t(file_in.tellg());
+}
+
+// write a grid of quads with at least the given number of triangles, returns actual number
+std::size_t write_obj(std::string const& path, std::size_t triangles) {
+  std::size_t quads_per_side = std::size_t(std::ceil(std::sqrt(double(triangles) / 2.0)));
+  std::size_t verts_per_side = quads_per_side + 1;
+  std::FILE* file_out = std::fopen(path.c_str(), "w");
+  if (!file_out) {
+    throw std::invalid_argument(path);
+  }
+  float scale = 1.0f / float(quads_per_side);
+  for (std::size_t y = 0; y < verts_per_side; ++y) {
+    for (std::size_t x = 0; x < verts_per_side; ++x) {
+      std::fprintf(file_out, "v %f %f 0.0\n", float(x) * scale, float(y) * scale);
+    }
+  }
+  for (std::size_t i = 0; i < verts_per_side * verts_per_side; ++i) {
+    std::fprintf(file_out, "vn 0.0 0.0 1.0\n");
+  }
+  for (std::size_t y = 0; y < quads_per_side; ++y) {
+    for (std::size_t x = 0; x < quads_per_side; ++x) {
+      // obj indices start at 1
+      std::size_t a = y * verts_per_side + x + 1;
+      std::size_t b = a + 1;
+      std::size_t c = a + verts_per_side;
+      std::size_t d = c + 1;
+      std::fprintf(file_out, "f %zu//%zu %zu//%zu %zu//%zu\n", a, a, b, b, d, d);
+      std::fprintf(file_out, "f %zu//%zu %zu//%zu %zu//%zu\n", a, a, d, d, c, c);
+    }
+  }
+  std::fclose(file_out);
+  return quads_per_side * quads_per_side * 2;
+}
+
+// write uncompressed 32 bit tga with a gradient
+void write_tga(std::string const& path, std::size_t size) {
+  std::vector<unsigned char> image(18 + size * size * 4, 0);
+  // uncompressed true color
+  image[2] = 2;
+  image[12] = (unsigned char)(size & 0xff);
+  image[13] = (unsigned char)(size >> 8);
+  image[14] = (unsigned char)(size & 0xff);
+  image[15] = (unsigned char)(size >> 8);
+  image[16] = 32;
+  // 8 alpha bits
+  image[17] = 8;
+  for (std::size_t i = 0; i < size * size; ++i) {
+    image[18 + i * 4 + 0] = (unsigned char)(i % size);
+    image[18 + i * 4 + 1] = (unsigned char)(i / size);
+    image[18 + i * 4 + 2] = (unsigned char)(i);
+    image[18 + i * 4 + 3] = 255;
+  }
+  std::ofstream file_out{path, std::ios::binary};
+  file_out.write(reinterpret_cast<char const*>(image.data()), std::streamsize(image.size()));
+}
+
+// write shader source of roughly the given size
+void write_shader(std::string const& path, std::size_t bytes) {
+  std::ofstream file_out{path};
+  file_out << "#version 150\n";
+  std::size_t written = 13;
+  for (std::size_t i = 0; written < bytes; ++i) {
+    std::string line = "uniform vec4 Parameter" + std::to_string(i) + ";\n";
+    file_out << line;
+    written += line.size();
+  }
+  file_out << "out vec4 out_Color;\nvoid main() {\n  out_Color = vec4(1.0);\n}\n";
+}
+
+void write_result(benchmark::json_writer& json, std::string const& loader, std::string const& input,
+                  std::size_t bytes, measurement const& result) {
+  json.key("loader").value(loader);
+  json.key("input").value(input);
+  json.key("bytes").value(bytes);
+  json.key("seconds_best").value(result.best_seconds);
+  json.key("seconds_average").value(result.average_seconds);
+  json.key("mb_per_s").value(double(bytes) / (1024.0 * 1024.0) / result.best_seconds);
+  json.key("allocations").value(result.allocations);
+  json.key("allocated_bytes").value(result.allocated_bytes);
+  json.key("peak_rss_increase").value(result.peak_rss_increase);
+}
+
+// usage: bench_loaders [resource path] [--max-triangles <n>] [--repetitions <n>] [--work-dir <dir>] [--report <file>]
+int main(int argc, char* argv[]) {
+  std::string resource_path{};
+  std::string work_dir{"."};
+  std::string report_path{};
+  std::size_t max_triangles = 1000000;
+  unsigned repetitions = 3;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if (arg == "--max-triangles" && i + 1 < argc) {
+      max_triangles = std::stoul(argv[++i]);
+    }
+    else if (arg == "--repetitions" && i + 1 < argc) {
+      repetitions = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--work-dir" && i + 1 < argc) {
+      work_dir = argv[++i];
+    }
+    else if (arg == "--report" && i + 1 < argc) {
+      report_path = argv[++i];
+    }
+    else if (resource_path.empty()) {
+      resource_path = arg;
+    }
+  }
+  // same default as launcher
+  if (resource_path.empty()) {
+    std::string exe_path{argv[0]};
+    resource_path = exe_path.substr(0, exe_path.find_last_of("/\\")) + "/../../resources/";
+  }
+
+  std::ofstream file_out{};
+  if (!report_path.empty()) {
+    file_out.open(report_path);
+  }
+  benchmark::json_writer json{file_out.is_open() ? file_out : std::cout};
+  json.begin_object();
+  json.key("repetitions").value(repetitions);
+  json.key("results").begin_array();
+
+  // models of increasing size, read raw and parsed
+  for (std::size_t triangles = 1000; triangles <= max_triangles; triangles *= 10) {
+    std::string path = work_dir + "/bench_grid_" + std::to_string(triangles) + ".obj";
+    std::size_t actual_triangles = write_obj(path, triangles);
+    std::size_t bytes = file_size(path);
+
+    measurement read = measure(repetitions, [&]() {
+      utils::read_file(path);
+    });
+    json.begin_object();
+    write_result(json, "utils::read_file", utils::file_name(path), bytes, read);
+    json.end_object();
+
+    for (model::attrib_flag_t attribs : {model::attrib_flag_t(model::POSITION), model::POSITION | model::NORMAL}) {
+      measurement load = measure(repetitions, [&]() {
+        model_loader::obj(path, attribs);
+      });
+      json.begin_object();
+      write_result(json, "model_loader::obj", utils::file_name(path), bytes, load);
+      json.key("triangles").value(actual_triangles);
+      json.key("normals").value((attribs & model::NORMAL) != 0);
+      json.end_object();
+    }
+    std::remove(path.c_str());
+  }
+
+  // textures of increasing resolution
+  for (std::size_t size = 256; size <= 4096; size *= 4) {
+    std::string path = work_dir + "/bench_texture_" + std::to_string(size) + ".tga";
+    write_tga(path, size);
+    measurement load = measure(repetitions, [&]() {
+      texture_loader::file(path);
+    });
+    json.begin_object();
+    write_result(json, "texture_loader::file", utils::file_name(path), file_size(path), load);
+    json.key("resolution").value(size);
+    json.end_object();
+    std::remove(path.c_str());
+  }
+
+  // shipped shader sources are tiny, repeat more often for stable timings
+  for (std::string name : {"simple.vert", "simple.frag", "stars.vert", "stars.frag"}) {
+    std::string path = resource_path + "shaders/" + name;
+    measurement load = measure(repetitions * 100, [&]() {
+      utils::read_file(path);
+    });
+    json.begin_object();
+    write_result(json, "shader source", name, file_size(path), load);
+    json.end_object();
+  }
+  // synthetic shader sources of increasing size
+  for (std::size_t bytes = 16 * 1024; bytes <= 4 * 1024 * 1024; bytes *= 16) {
+    std::string path = work_dir + "/bench_shader_" + std::to_string(bytes) + ".frag";
+    write_shader(path, bytes);
+    measurement load = measure(repetitions, [&]() {
+      utils::read_file(path);
+    });
+    json.begin_object();
+    write_result(json, "shader source", utils::file_name(path), file_size(path), load);
+    json.end_object();
+    std::remove(path.c_str());
+  }
+
+  json.end_array();
+  json.end_object();
+}
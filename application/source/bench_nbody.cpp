@@ -0,0 +1,102 @@
+#include "benchmark.hpp"
+#include "nbody.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// disc of bodies around a heavy center, comparable to the asteroid belt of the solar system
+nbody_system create_disc(std::size_t count, float gravity) {
+  nbody_system bodies{};
+  const float central_mass = 1000.0f;
+  bodies.add(glm::fvec3{0.0f}, glm::fvec3{0.0f}, central_mass);
+  add_ring(bodies, 1, count - 1, glm::fvec3{0.0f}, glm::fvec3{0.0f}, central_mass, 5.0f, 50.0f, 1.0f, 0.001f, gravity);
+  return bodies;
+}
+
+// usage: bench_nbody [--max-bodies <n>] [--max-threads <n>] [--steps <n>] [--opening-angle <theta>] [--report <file>]
+int main(int argc, char* argv[]) {
+  std::string report_path{};
+  std::size_t max_bodies = 100000;
+  unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  unsigned steps = 5;
+  gravity_settings settings{};
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if (arg == "--max-bodies" && i + 1 < argc) {
+      max_bodies = std::stoul(argv[++i]);
+    }
+    else if (arg == "--max-threads" && i + 1 < argc) {
+      max_threads = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--steps" && i + 1 < argc) {
+      steps = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--opening-angle" && i + 1 < argc) {
+      settings.opening_angle = std::stof(argv[++i]);
+    }
+    else if (arg == "--report" && i + 1 < argc) {
+      report_path = argv[++i];
+    }
+  }
+
+  std::ofstream file_out{};
+  if (!report_path.empty()) {
+    file_out.open(report_path);
+  }
+  benchmark::json_writer json{file_out.is_open() ? file_out : std::cout};
+  json.begin_object();
+  json.key("steps").value(steps);
+  json.key("opening_angle").value(double(settings.opening_angle));
+  json.key("hardware_threads").value(std::thread::hardware_concurrency());
+  json.key("results").begin_array();
+
+  std::vector<std::size_t> body_counts{};
+  for (std::size_t count = 1000; count <= max_bodies; count *= 10) {
+    body_counts.push_back(count);
+  }
+  if (body_counts.empty() || body_counts.back() != max_bodies) {
+    body_counts.push_back(max_bodies);
+  }
+  std::vector<unsigned> thread_counts{};
+  for (unsigned threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  for (std::size_t count : body_counts) {
+    for (unsigned threads : thread_counts) {
+      settings.threads = threads;
+      // every run starts from the same state
+      nbody_system bodies = create_disc(count, settings.gravity);
+      barnes_hut tree{};
+      tree.build(bodies);
+      tree.accelerate(bodies, settings);
+
+      double start = benchmark::now();
+      for (unsigned step = 0; step < steps; ++step) {
+        leapfrog_step(bodies, tree, settings, 0.001f);
+      }
+      double total_seconds = benchmark::now() - start;
+      // share of the single threaded tree construction in a step
+      start = benchmark::now();
+      tree.build(bodies);
+      double build_seconds = benchmark::now() - start;
+
+      json.begin_object();
+      json.key("bodies").value(count);
+      json.key("threads").value(threads);
+      json.key("steps_per_s").value(double(steps) / total_seconds);
+      json.key("ms_per_step").value(total_seconds / double(steps) * 1000.0);
+      json.key("build_ms").value(build_seconds * 1000.0);
+      json.key("nodes").value(tree.node_count());
+      json.end_object();
+    }
+  }
+
+  json.end_array();
+  json.end_object();
+}
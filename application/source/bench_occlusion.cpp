@@ -0,0 +1,149 @@
+#include "benchmark.hpp"
+#include "occlusion.hpp"
+#include "star_field.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// unit sphere as latitude longitude grid, positions only
+void create_sphere(unsigned segments, std::vector<float>& positions, std::vector<std::uint32_t>& indices) {
+  const float pi = 3.14159265f;
+  for (unsigned lat = 0; lat <= segments; ++lat) {
+    float theta = pi * float(lat) / float(segments);
+    for (unsigned lon = 0; lon <= segments; ++lon) {
+      float phi = 2.0f * pi * float(lon) / float(segments);
+      positions.push_back(std::sin(theta) * std::cos(phi));
+      positions.push_back(std::cos(theta));
+      positions.push_back(std::sin(theta) * std::sin(phi));
+    }
+  }
+  for (unsigned lat = 0; lat < segments; ++lat) {
+    for (unsigned lon = 0; lon < segments; ++lon) {
+      std::uint32_t first = lat * (segments + 1) + lon;
+      std::uint32_t below = first + segments + 1;
+      indices.insert(indices.end(), {first, below, first + 1, first + 1, below, below + 1});
+    }
+  }
+}
+
+// usage: bench_occlusion [--width <n>] [--height <n>] [--occluders <n>] [--boxes <n>] [--frames <n>] [--max-threads <n>] [--report <file>]
+int main(int argc, char* argv[]) {
+  std::string report_path{};
+  std::size_t width = 256;
+  std::size_t height = 128;
+  unsigned occluders = 3;
+  std::size_t box_count = 10000;
+  unsigned frames = 100;
+  unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if (arg == "--width" && i + 1 < argc) {
+      width = std::stoul(argv[++i]);
+    }
+    else if (arg == "--height" && i + 1 < argc) {
+      height = std::stoul(argv[++i]);
+    }
+    else if (arg == "--occluders" && i + 1 < argc) {
+      occluders = unsigned(std::stoul(argv[++i]));
+    }
+    else if (arg == "--boxes" && i + 1 < argc) {
+      box_count = std::stoul(argv[++i]);
+    }
+    else if (arg == "--frames" && i + 1 < argc) {
+      frames = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--max-threads" && i + 1 < argc) {
+      max_threads = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--report" && i + 1 < argc) {
+      report_path = argv[++i];
+    }
+  }
+
+  // same mesh resolution as the solar system sphere
+  std::vector<float> sphere_positions{};
+  std::vector<std::uint32_t> sphere_indices{};
+  create_sphere(44, sphere_positions, sphere_indices);
+
+  // row of large spheres in front of a field of small boxes, like the sun and planets in front of the asteroid belt
+  glm::fmat4 projection = glm::perspective(glm::radians(60.0f), float(width) / float(height), 0.1f, 200.0f);
+  glm::fmat4 view = glm::lookAt(glm::fvec3{0.0f, 0.0f, 30.0f}, glm::fvec3{0.0f}, glm::fvec3{0.0f, 1.0f, 0.0f});
+  std::vector<glm::fmat4> occluder_transforms{};
+  for (unsigned i = 0; i < occluders; ++i) {
+    float x = (float(i) - float(occluders - 1) * 0.5f) * 7.0f;
+    occluder_transforms.push_back(glm::scale(glm::translate(glm::fmat4{}, glm::fvec3{x, 0.0f, 0.0f}), glm::fvec3{3.0f}));
+  }
+  std::vector<aabb> boxes(box_count);
+  for (std::size_t i = 0; i < box_count; ++i) {
+    std::uint32_t counter = std::uint32_t(i * 3);
+    glm::fvec3 center{random_unit(7, counter) * 40.0f - 20.0f, random_unit(7, counter + 1) * 16.0f - 8.0f, -random_unit(7, counter + 2) * 40.0f};
+    boxes[i] = aabb{center - 0.2f, center + 0.2f};
+  }
+
+  std::ofstream file_out{};
+  if (!report_path.empty()) {
+    file_out.open(report_path);
+  }
+  benchmark::json_writer json{file_out.is_open() ? file_out : std::cout};
+  json.begin_object();
+  json.key("frames").value(frames);
+  json.key("boxes").value(box_count);
+  json.key("occluders").value(occluders);
+  json.key("hardware_threads").value(std::thread::hardware_concurrency());
+  json.key("results").begin_array();
+
+  std::vector<unsigned> thread_counts{};
+  for (unsigned threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  occlusion_buffer buffer{width, height};
+  std::vector<std::uint32_t> visible{};
+  for (unsigned threads : thread_counts) {
+    double setup_seconds = 0.0;
+    double raster_seconds = 0.0;
+    double test_seconds = 0.0;
+    for (unsigned frame = 0; frame < frames; ++frame) {
+      double start = benchmark::now();
+      buffer.begin(projection * view);
+      for (glm::fmat4 const& transform : occluder_transforms) {
+        buffer.add_occluder(transform, sphere_positions.data(), sphere_positions.size() / 3, 3, sphere_indices.data(), sphere_indices.size());
+      }
+      double setup_end = benchmark::now();
+      buffer.finish(threads);
+      double raster_end = benchmark::now();
+      visible.resize(box_count);
+      for (std::size_t i = 0; i < box_count; ++i) {
+        visible[i] = std::uint32_t(i);
+      }
+      buffer.cull(boxes, visible);
+      double test_end = benchmark::now();
+      setup_seconds += setup_end - start;
+      raster_seconds += raster_end - setup_end;
+      test_seconds += test_end - raster_end;
+    }
+
+    json.begin_object();
+    json.key("width").value(buffer.width());
+    json.key("height").value(buffer.height());
+    json.key("threads").value(threads);
+    json.key("triangles").value(buffer.triangle_count());
+    json.key("setup_ms").value(setup_seconds / double(frames) * 1000.0);
+    json.key("raster_ms").value(raster_seconds / double(frames) * 1000.0);
+    json.key("test_ms").value(test_seconds / double(frames) * 1000.0);
+    json.key("ns_per_box").value(test_seconds / double(frames) / double(std::max(box_count, std::size_t(1))) * 1e9);
+    json.key("occluded").value(box_count - visible.size());
+    json.end_object();
+  }
+
+  json.end_array();
+  json.end_object();
+}
@@ -0,0 +1,93 @@
+#include "benchmark.hpp"
+#include "procedural_mesh.hpp"
+#include "star_field.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// usage: bench_procedural [--max-stars <n>] [--max-threads <n>] [--repetitions <n>] [--report <file>]
+// times the generation of procedural content, which is computed instead of loaded
+int main(int argc, char* argv[]) {
+  std::string report_path{};
+  std::size_t max_stars = 10000000;
+  unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  unsigned repetitions = 5;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if (arg == "--max-stars" && i + 1 < argc) {
+      max_stars = std::max(std::size_t(1), std::size_t(std::stoul(argv[++i])));
+    }
+    else if (arg == "--max-threads" && i + 1 < argc) {
+      max_threads = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--repetitions" && i + 1 < argc) {
+      repetitions = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--report" && i + 1 < argc) {
+      report_path = argv[++i];
+    }
+  }
+
+  std::ofstream file_out{};
+  if (!report_path.empty()) {
+    file_out.open(report_path);
+  }
+  benchmark::json_writer json{file_out.is_open() ? file_out : std::cout};
+  json.begin_object();
+  json.key("repetitions").value(repetitions);
+  json.key("hardware_threads").value(std::thread::hardware_concurrency());
+  json.key("results").begin_array();
+
+  std::vector<unsigned> thread_counts{};
+  for (unsigned threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  // star fields up to the largest supported size
+  for (std::size_t count = 100000; ; count = std::min(count * 10, max_stars)) {
+    for (unsigned threads : thread_counts) {
+      double best_seconds = 1e300;
+      for (unsigned i = 0; i < repetitions; ++i) {
+        double start = benchmark::now();
+        std::vector<star_point> stars = generate_star_field(1, count, 100.0f, threads);
+        best_seconds = std::min(best_seconds, benchmark::now() - start);
+      }
+      json.begin_object();
+      json.key("generator").value("generate_star_field");
+      json.key("stars").value(count);
+      json.key("threads").value(threads);
+      json.key("best_ms").value(best_seconds * 1000.0);
+      json.key("mstars_per_s").value(double(count) / best_seconds / 1e6);
+      json.end_object();
+    }
+    if (count >= max_stars) {
+      break;
+    }
+  }
+
+  // sphere levels as generated for the bodies, up to the finest level and beyond
+  for (unsigned subdivisions = 2; subdivisions <= 128; subdivisions *= 2) {
+    double best_seconds = 1e300;
+    std::size_t bytes = 0;
+    for (unsigned i = 0; i < repetitions; ++i) {
+      double start = benchmark::now();
+      model sphere = cube_sphere(subdivisions, model::NORMAL | model::TEXCOORD);
+      best_seconds = std::min(best_seconds, benchmark::now() - start);
+      bytes = sphere.data.size() * sizeof(GLfloat) + sphere.indices.size() * sizeof(GLuint);
+    }
+    json.begin_object();
+    json.key("generator").value("cube_sphere");
+    json.key("triangles").value(12 * subdivisions * subdivisions);
+    json.key("bytes").value(bytes);
+    json.key("best_ms").value(best_seconds * 1000.0);
+    json.end_object();
+  }
+
+  json.end_array();
+  json.end_object();
+}
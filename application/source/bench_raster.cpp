@@ -0,0 +1,162 @@
+#include "benchmark.hpp"
+#include "body_store.hpp"
+#include "model_loader.hpp"
+#include "scene_graph.hpp"
+#include "software_renderer.hpp"
+#include "texture_loader.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// scale and orbit of the solar system bodies, satellites follow their parent
+struct bench_body {
+  int parent;
+  float size;
+  orbit motion;
+};
+
+bench_body const bench_bodies[] = {
+  {-1, 1.5f, {0.0f, 0.0f, 0.0f}},
+  {0, 0.3f, {2.0f, 1.0f, 0.0f}},
+  {0, 0.4f, {6.0f, 1.0f, 1.0f}},
+  {0, 0.5f, {9.0f, 1.0f, 2.0f}},
+  {0, 0.3f, {14.0f, 1.0f, 3.0f}},
+  {0, 1.6f, {20.0f, 1.0f, 4.0f}},
+  {0, 1.2f, {30.0f, 1.0f, 5.0f}},
+  {0, 0.8f, {40.0f, 1.0f, 6.0f}},
+  {0, 0.6f, {50.0f, 1.0f, 7.0f}},
+  {3, 0.3f, {1.5f, 4.0f, 2.0f}}
+};
+
+// usage: bench_raster [resource path] [--size <width>x<height>] [--frames <n>] [--max-threads <n>]
+//                     [--output <tga>] [--golden <tga>] [--tolerance <n>] [--report <file>]
+// renders the solar system at a fixed time with the software renderer, optionally writes the image
+// and compares it with a golden image, returns 1 if pixels differ by more than the tolerance
+int main(int argc, char* argv[]) {
+  std::string resource_path{};
+  std::string report_path{};
+  std::string output_path{};
+  std::string golden_path{};
+  std::size_t width = 1280;
+  std::size_t height = 720;
+  unsigned frames = 20;
+  unsigned tolerance = 1;
+  unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if (arg == "--size" && i + 1 < argc) {
+      std::string size{argv[++i]};
+      std::size_t separator = size.find('x');
+      if (separator != std::string::npos) {
+        width = std::stoul(size.substr(0, separator));
+        height = std::stoul(size.substr(separator + 1));
+      }
+    }
+    else if (arg == "--frames" && i + 1 < argc) {
+      frames = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--max-threads" && i + 1 < argc) {
+      max_threads = std::max(1u, unsigned(std::stoul(argv[++i])));
+    }
+    else if (arg == "--output" && i + 1 < argc) {
+      output_path = argv[++i];
+    }
+    else if (arg == "--golden" && i + 1 < argc) {
+      golden_path = argv[++i];
+    }
+    else if (arg == "--tolerance" && i + 1 < argc) {
+      tolerance = unsigned(std::stoul(argv[++i]));
+    }
+    else if (arg == "--report" && i + 1 < argc) {
+      report_path = argv[++i];
+    }
+    // first positional argument is resource path
+    else if (arg.compare(0, 2, "--") != 0 && resource_path.empty()) {
+      resource_path = arg;
+    }
+  }
+  // same default as the launcher
+  if (resource_path.empty()) {
+    std::string exe_path{argv[0]};
+    resource_path = exe_path.substr(0, exe_path.find_last_of("/\\")) + "/../../resources/";
+  }
+
+  model sphere = model_loader::obj(resource_path + "models/sphere.obj", model::NORMAL);
+  scene_graph scene{};
+  body_store bodies{};
+  for (auto const& body : bench_bodies) {
+    bodies.add(scene, body.parent, body.motion, body.size, 0, BODY_DRAW);
+  }
+  // fixed time, every run renders the same image
+  update_orbits(bodies, 1.0f, scene);
+  scene.update();
+
+  glm::fmat4 view = glm::lookAt(glm::fvec3{0.0f, 20.0f, 45.0f}, glm::fvec3{0.0f}, glm::fvec3{0.0f, 1.0f, 0.0f});
+  glm::fmat4 projection = glm::perspective(glm::radians(60.0f), float(width) / float(height), 0.1f, 100.0f);
+  software_renderer renderer{width, height};
+  auto render_frame = [&](unsigned threads) {
+    renderer.set_camera(view, projection);
+    renderer.clear(glm::fvec4{0.0f, 0.0f, 0.0f, 1.0f});
+    for (std::size_t i = 0; i < bodies.size(); ++i) {
+      renderer.draw(sphere, scene.world(bodies.mesh_nodes[i]), scene.normal(bodies.mesh_nodes[i]));
+    }
+    renderer.finish(threads);
+  };
+
+  std::ofstream file_out{};
+  if (!report_path.empty()) {
+    file_out.open(report_path);
+  }
+  benchmark::json_writer json{file_out.is_open() ? file_out : std::cout};
+  json.begin_object();
+  json.key("width").value(width);
+  json.key("height").value(height);
+  json.key("frames").value(frames);
+  json.key("hardware_threads").value(std::thread::hardware_concurrency());
+  json.key("results").begin_array();
+
+  std::vector<unsigned> thread_counts{};
+  for (unsigned threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+  for (unsigned threads : thread_counts) {
+    // warm up allocations of the bins
+    render_frame(threads);
+    double start = benchmark::now();
+    for (unsigned frame = 0; frame < frames; ++frame) {
+      render_frame(threads);
+    }
+    double seconds = benchmark::now() - start;
+    json.begin_object();
+    json.key("threads").value(threads);
+    json.key("triangles").value(renderer.triangle_count());
+    json.key("fps").value(double(frames) / seconds);
+    json.key("ms_per_frame").value(seconds / double(frames) * 1000.0);
+    json.end_object();
+  }
+  json.end_array();
+
+  pixel_data image = renderer.image();
+  if (!output_path.empty()) {
+    write_tga(output_path, image);
+  }
+  int result = 0;
+  if (!golden_path.empty()) {
+    image_difference difference = compare_images(image, texture_loader::file(golden_path), tolerance);
+    json.key("golden").begin_object();
+    json.key("max_difference").value(difference.max_difference);
+    json.key("differing_pixels").value(difference.differing_pixels);
+    json.key("mean_difference").value(difference.mean_difference);
+    json.end_object();
+    result = difference.differing_pixels > 0 ? 1 : 0;
+  }
+  json.end_object();
+  return result;
+}
@@ -0,0 +1,23 @@
+#include "application_solar.hpp"
+#include "launcher.hpp"
+
+#include <string>
+#include <vector>
+
+// benchmark entry point, replays a camera flight headless with a fixed simulation clock
+// and prints frame statistics as json, given arguments override the defaults
+int main(int argc, char* argv[]) {
+  std::vector<std::string> arguments{argv[0],
+    "--headless", "--fixed-clock",
+    "--size", "1280x720",
+    "--frames", "600",
+    "--replay", "benchmarks/solar_camera.txt"};
+  arguments.insert(arguments.end(), argv + 1, argv + argc);
+
+  // launcher expects mutable c-strings
+  std::vector<char*> argument_ptrs{};
+  for (auto& argument : arguments) {
+    argument_ptrs.push_back(&argument[0]);
+  }
+  Launcher::run<ApplicationSolar>(int(argument_ptrs.size()), argument_ptrs.data());
+}
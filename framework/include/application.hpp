@@ -20,12 +20,22 @@ class Application {
   // update projection matrix
   void setProjection(glm::fmat4 const& projection_mat);
   virtual void updateProjection() = 0;
+  // advance simulation by one fixed time step in seconds
+  inline virtual void update(double delta_time) {};
+  // set blend factor between the last two simulation steps for rendering
+  void setFrameInterpolation(float alpha);
   // react to key input
   inline virtual void keyCallback(int key, int scancode, int action, int mods) {};
   // react to mouse scroll
     inline virtual void mouseScrollCallback(double x, double y) {};
   // 
   virtual std::map<std::string, shader_program>& getShaderPrograms();
+  // copy the state render needs into a snapshot, called on the simulation thread after the updates
+  inline virtual void publish() {};
+  // take the latest published snapshot, called on the gl thread before render
+  inline virtual void acquire() {};
+  // whether render only reads acquired snapshots, required to render on a separate thread
+  inline virtual bool renders_snapshots() const { return false; };
   // draw all objects
   virtual void render() const = 0;
 
@@ -36,6 +46,10 @@ class Application {
 
   glm::fmat4 m_view_transform;
   glm::fmat4 m_view_projection;
+  // whether setProjection was called, until then m_view_projection is the identity
+  bool m_projection_set;
+  // fraction of a time step the rendered frame lies past the last update
+  float m_frame_alpha;
 
   // container for the shader programs
   std::map<std::string, shader_program> m_shaders{};
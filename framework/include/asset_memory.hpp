@@ -0,0 +1,72 @@
+#ifndef ASSET_MEMORY_HPP
+#define ASSET_MEMORY_HPP
+
+#include "benchmark.hpp"
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// cpu and gpu bytes held by every loaded asset, shows what keeps memory resident
+// assets register themselves when created and are removed when freed, all functions are thread safe
+class asset_memory {
+ public:
+  // what happens to cpu copies once their data is resident on the gpu
+  enum policy {
+    KEEP_CPU_COPIES,
+    // free copies that are not read on the cpu, like for picking or collision
+    EVICT_CPU_COPIES
+  };
+
+  typedef std::size_t handle;
+
+  struct entry {
+    std::string name;
+    // kind of asset, like model, texture or buffer
+    std::string category;
+    std::size_t cpu_bytes;
+    std::size_t gpu_bytes;
+    // cpu copy was freed after the upload
+    bool evicted;
+  };
+
+  // registry shared by the framework
+  static asset_memory& instance();
+
+  handle track(std::string const& name, std::string const& category, std::size_t cpu_bytes = 0, std::size_t gpu_bytes = 0);
+  void set_cpu_bytes(handle asset, std::size_t bytes);
+  void set_gpu_bytes(handle asset, std::size_t bytes);
+  // cpu copy of the asset was freed
+  void evicted(handle asset);
+  void untrack(handle asset);
+
+  void set_policy(policy residency);
+  policy get_policy() const;
+  // whether the cpu copy of an asset should be freed after its upload
+  bool evict_after_upload(bool needed_on_cpu) const;
+
+  // registered assets in registration order
+  std::vector<entry> entries() const;
+  // sums over all assets
+  std::size_t cpu_bytes() const;
+  std::size_t gpu_bytes() const;
+
+  // totals and every asset as json object
+  void write(benchmark::json_writer& json) const;
+  // table sorted by total size
+  void print(std::ostream& stream) const;
+
+ private:
+  asset_memory();
+
+  mutable std::mutex m_mutex;
+  // ordered by handle, so by registration
+  std::map<handle, entry> m_entries;
+  handle m_next;
+  policy m_policy;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+  // time of one frame in seconds, the phases in cpu time of the thread running them
+  struct frame_sample {
+    // wall clock time of the whole frame
+    double total = 0.0;
+    double poll = 0.0;
+    double update = 0.0;
+    double render = 0.0;
+    double present = 0.0;
+    unsigned draw_calls = 0;
+  };
+
+  // key event to replay at the start of a frame
+  struct input_event {
+    unsigned frame;
+    int key;
+    int action;
+    int mods;
+  };
+
+  // read timeline with one "frame key action mods" event per line, '#' starts a comment
+  std::vector<input_event> read_input_timeline(std::string const& file_path);
+  // write timeline in the format expected by read_input_timeline
+  void write_input_timeline(std::string const& file_path, std::vector<input_event> const& events);
+
+  // value below which the given fraction of values lies, nearest rank
+  double percentile(std::vector<double> values, double fraction);
+  // current time in seconds from a monotonic clock
+  double now();
+  // cpu time consumed by the calling thread in seconds, wall clock time where unsupported
+  double thread_cpu_time();
+  // peak resident set size of the process in bytes, 0 if unsupported
+  std::size_t peak_rss();
+
+  // minimal streaming json output for machine-readable reports
+  class json_writer {
+   public:
+    json_writer(std::ostream& stream);
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+    // name the following value inside an object
+    json_writer& key(std::string const& name);
+
+    // integer types
+    template<typename T>
+    void value(T number) {
+      separate();
+      m_stream << number;
+    }
+    void value(double number);
+    void value(bool boolean);
+    void value(std::string const& text);
+    void value(char const* text);
+
+   private:
+    // write separator if a sibling precedes the next element
+    void separate();
+
+    std::ostream& m_stream;
+    // whether the current nesting level already has an element
+    std::vector<bool> m_has_element;
+    // a key was just written, value follows without separator
+    bool m_after_key;
+  };
+
+  // write summary statistics of recorded frames as json object
+  void write_frame_report(json_writer& json, std::vector<frame_sample> const& frames);
+}
+
+#endif
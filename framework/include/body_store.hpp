@@ -0,0 +1,62 @@
+#ifndef BODY_STORE_HPP
+#define BODY_STORE_HPP
+
+#include "scene_graph.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// circular motion around the parent body
+struct orbit {
+  // distance from parent
+  float radius;
+  // radians per second
+  float angular_speed;
+  // angle at time zero
+  float phase;
+};
+
+// flags controlling how a body is processed, combined bitwise
+enum body_flag : std::uint8_t {
+  // body is rendered
+  BODY_DRAW = 1 << 0,
+  // body does not move relative to its parent, skipped by orbit updates
+  BODY_STATIC = 1 << 1,
+  // body is rasterized into the occlusion buffer to cull bodies behind it
+  BODY_OCCLUDER = 1 << 2,
+  // body gives off light, drawn with its surface colour instead of being lit
+  BODY_EMISSIVE = 1 << 3
+};
+
+// scene bodies as structure of arrays, a body index addresses the same element in each array
+struct body_store {
+  // add body orbiting parent body or the origin if parent is negative, returns body index
+  std::size_t add(scene_graph& scene, int parent, orbit const& motion, float scale, std::uint32_t mesh, std::uint8_t flags, std::uint32_t surface = 0);
+  // number of bodies
+  std::size_t size() const;
+
+  // hot data, iterated every frame
+  std::vector<orbit> orbits;
+  std::vector<float> scales;
+  std::vector<std::uint8_t> flags;
+  // world space center, valid after gather_positions
+  std::vector<glm::fvec3> positions;
+  // scene graph node children are attached to
+  std::vector<std::size_t> orbit_nodes;
+  // scene graph node additionally holding the scale, used for drawing
+  std::vector<std::size_t> mesh_nodes;
+  // index into the application's mesh table
+  std::vector<std::uint32_t> meshes;
+  // index into the application's surface textures
+  std::vector<std::uint32_t> surfaces;
+};
+
+// write orbit transforms at given time into the scene graph
+void update_orbits(body_store const& bodies, float time, scene_graph& scene);
+// copy world space centers from the updated scene graph
+void gather_positions(body_store& bodies, scene_graph const& scene);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef BUFFER_TEXTURE_HPP
+#define BUFFER_TEXTURE_HPP
+
+#include "asset_memory.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <cstddef>
+#include <string>
+
+// buffer read by shaders through texelFetch on a samplerBuffer, for arrays too large for uniforms
+// the whole content is replaced by the cpu when it changes, the old storage is orphaned so draws still reading it do not stall
+class buffer_texture {
+ public:
+  // format is the sized internal format of one texel, like GL_RGBA32F, name appears in the asset accounting
+  buffer_texture(GLenum format, std::string const& name);
+  ~buffer_texture();
+  buffer_texture(buffer_texture const&) = delete;
+  buffer_texture& operator=(buffer_texture const&) = delete;
+
+  // replace the content, the storage only grows
+  void update(void const* data, std::size_t bytes);
+  // bind the texture to a texture unit, leaves unit 0 active
+  void bind(GLuint unit) const;
+
+  GLuint texture() const;
+  // bytes of the last update
+  std::size_t size() const;
+
+ private:
+  GLenum m_format;
+  GLuint m_buffer;
+  GLuint m_texture;
+  std::size_t m_capacity;
+  std::size_t m_size;
+  asset_memory::handle m_asset;
+};
+
+#endif
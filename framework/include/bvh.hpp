@@ -0,0 +1,68 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include "culling.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// axis aligned bounding box
+struct aabb {
+  glm::fvec3 min;
+  glm::fvec3 max;
+};
+
+// bounding volume hierarchy over boxes, built once and refitted when primitives move
+class bvh {
+ public:
+  // contiguous range in the primitive order of the hierarchy
+  struct range {
+    std::uint32_t first;
+    std::uint32_t count;
+  };
+
+  bvh();
+
+  // build hierarchy with at most leaf_size primitives per leaf
+  void build(std::vector<aabb> const& boxes, std::size_t leaf_size = 4);
+  // recompute node bounds for moved primitives, keeps the topology
+  void refit(std::vector<aabb> const& boxes);
+
+  // append indices of primitives overlapping the frustum
+  void query_frustum(frustum const& volume, std::vector<std::uint32_t>& result) const;
+  // append leaf ranges overlapping the frustum, for data reordered by primitive_order
+  void query_frustum(frustum const& volume, std::vector<range>& result) const;
+  // append indices of primitives overlapping the sphere
+  void query_sphere(glm::fvec3 const& center, float radius, std::vector<std::uint32_t>& result) const;
+  // index of primitive with smallest distance to point, -1 if none is closer than max_distance
+  int nearest(glm::fvec3 const& point, float max_distance = 1e30f) const;
+  // index of first primitive hit by ray, -1 if none, writes ray parameter of hit
+  int raycast(glm::fvec3 const& origin, glm::fvec3 const& direction, float& distance) const;
+
+  // primitive indices in hierarchy order, leaves reference contiguous ranges of it
+  std::vector<std::uint32_t> const& primitive_order() const;
+  std::size_t node_count() const;
+
+ private:
+  struct node {
+    aabb bounds;
+    // left child of inner nodes, the right child follows it, zero for leaves
+    std::uint32_t children;
+    // primitives below the node, a contiguous range of the primitive order
+    std::uint32_t first;
+    std::uint32_t count;
+  };
+
+  void build_node(std::uint32_t node_index, std::uint32_t first, std::uint32_t count);
+
+  std::vector<node> m_nodes;
+  std::vector<std::uint32_t> m_primitives;
+  std::vector<aabb> m_boxes;
+  // boxes in primitive order, leaves crossing a frustum plane test theirs in batches
+  bounding_boxes m_ordered_boxes;
+  std::size_t m_leaf_size;
+};
+
+#endif
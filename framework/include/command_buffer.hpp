@@ -0,0 +1,203 @@
+#ifndef COMMAND_BUFFER_HPP
+#define COMMAND_BUFFER_HPP
+
+#include "job_system.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// commands are stored as header followed by their payload struct, independent of the graphics api
+namespace command {
+  enum type : std::uint32_t {
+    USE_PROGRAM,
+    BIND_VERTEX_ARRAY,
+    BIND_BUFFER,
+    UNIFORM_MATRIX,
+    UNIFORM_VECTOR,
+    ATTRIBUTE_POINTER,
+    ATTRIBUTE_CONSTANT,
+    DRAW_ARRAYS,
+    MULTI_DRAW_ARRAYS,
+    DRAW_INDEXED
+  };
+
+  enum primitive : std::uint32_t {
+    POINTS,
+    LINES,
+    TRIANGLES
+  };
+
+  enum buffer_target : std::uint32_t {
+    ARRAY_BUFFER,
+    ELEMENT_BUFFER,
+    UNIFORM_BUFFER
+  };
+
+  struct header {
+    type kind;
+    // payload bytes following the header
+    std::uint32_t size;
+  };
+
+  struct use_program {
+    std::uint32_t program;
+  };
+  struct bind_vertex_array {
+    std::uint32_t vertex_array;
+  };
+  struct bind_buffer {
+    buffer_target target;
+    std::uint32_t buffer;
+  };
+  struct uniform_matrix {
+    std::int32_t location;
+    glm::fmat4 value;
+  };
+  struct uniform_vector {
+    std::int32_t location;
+    glm::fvec4 value;
+  };
+  // float attribute read from the bound array buffer
+  struct attribute_pointer {
+    std::uint32_t location;
+    std::uint32_t components;
+    std::uint32_t stride;
+    std::uint64_t offset;
+  };
+  // value of an attribute without enabled array
+  struct attribute_constant {
+    std::uint32_t location;
+    glm::fvec4 value;
+  };
+  struct draw_arrays {
+    primitive mode;
+    std::int32_t first;
+    std::int32_t count;
+  };
+  // followed by range_count firsts and range_count counts
+  struct multi_draw_arrays {
+    primitive mode;
+    std::uint32_t range_count;
+  };
+  // 32 bit indices from the bound element buffer, first_index counts indices, not bytes
+  struct draw_indexed {
+    primitive mode;
+    std::int32_t index_count;
+    std::uint64_t first_index;
+    std::int32_t base_vertex;
+    std::int32_t instances;
+  };
+}
+
+// list of recorded commands, each buffer is written by a single thread
+class command_buffer {
+ public:
+  command_buffer();
+
+  void use_program(std::uint32_t program);
+  void bind_vertex_array(std::uint32_t vertex_array);
+  void bind_buffer(command::buffer_target target, std::uint32_t buffer);
+  void uniform(std::int32_t location, glm::fmat4 const& value);
+  void uniform(std::int32_t location, glm::fvec4 const& value);
+  void attribute_pointer(std::uint32_t location, std::uint32_t components, std::uint32_t stride, std::uint64_t offset);
+  void attribute_constant(std::uint32_t location, glm::fvec4 const& value);
+  void draw_arrays(command::primitive mode, std::int32_t first, std::int32_t count);
+  void multi_draw_arrays(command::primitive mode, std::int32_t const* firsts, std::int32_t const* counts, std::uint32_t range_count);
+  void draw_indexed(command::primitive mode, std::int32_t index_count, std::uint64_t first_index, std::int32_t base_vertex, std::int32_t instances = 1);
+
+  // remove all commands, keeps the memory
+  void clear();
+  bool empty() const;
+  std::size_t command_count() const;
+  // raw stream of headers and payloads
+  std::vector<unsigned char> const& data() const;
+
+ private:
+  // append header and payload, payload sizes are padded to keep headers aligned
+  unsigned char* push(command::type kind, std::size_t size);
+  template<typename T>
+  void push(command::type kind, T const& payload);
+
+  std::vector<unsigned char> m_data;
+  std::size_t m_count;
+};
+
+// sequential reading of a recorded buffer
+class command_reader {
+ public:
+  explicit command_reader(command_buffer const& commands);
+
+  // advance to the next command, false at the end
+  bool next();
+  command::type kind() const;
+  // payload of the current command, copied because the stream is not aligned for every type
+  template<typename T>
+  T payload() const;
+  // bytes after the payload struct, for variable sized commands
+  unsigned char const* trailing(std::size_t payload_size) const;
+
+ private:
+  // header of the current command
+  unsigned char const* m_position;
+  unsigned char const* m_next;
+  unsigned char const* m_end;
+  command::header m_header;
+};
+
+// ordered buffers of one frame, executed front to back
+class command_stream {
+ public:
+  command_stream();
+
+  // next empty buffer, references are invalidated by further appends
+  command_buffer& append();
+  // add count empty buffers and return the index of the first
+  std::size_t append(std::size_t count);
+  command_buffer& buffer(std::size_t index);
+  command_buffer const& buffer(std::size_t index) const;
+  std::size_t size() const;
+  // empty all buffers, memory of the buffers is reused for the next frame
+  void clear();
+
+ private:
+  std::vector<command_buffer> m_buffers;
+  std::size_t m_size;
+};
+
+// record [begin, end) in chunks of grain elements on the job system, each chunk into its own buffer
+// appended to the stream in chunk order, so the stream equals a serial recording
+// record is called as record(first, last, command_buffer&)
+template<typename F>
+void record_parallel(command_stream& stream, std::size_t begin, std::size_t end, std::size_t grain, F const& record) {
+  if (end <= begin) {
+    return;
+  }
+  grain = std::max(grain, std::size_t(1));
+  std::size_t chunks = (end - begin + grain - 1) / grain;
+  std::size_t first_buffer = stream.append(chunks);
+  parallel_for(0, chunks, 1, [&](std::size_t first_chunk, std::size_t last_chunk) {
+    for (std::size_t chunk = first_chunk; chunk < last_chunk; ++chunk) {
+      std::size_t first = begin + chunk * grain;
+      record(first, std::min(first + grain, end), stream.buffer(first_buffer + chunk));
+    }
+  });
+}
+
+template<typename T>
+void command_buffer::push(command::type kind, T const& payload) {
+  unsigned char const* bytes = reinterpret_cast<unsigned char const*>(&payload);
+  std::copy(bytes, bytes + sizeof(T), push(kind, sizeof(T)));
+}
+
+template<typename T>
+T command_reader::payload() const {
+  T result;
+  unsigned char const* bytes = m_position + sizeof(command::header);
+  std::copy(bytes, bytes + sizeof(T), reinterpret_cast<unsigned char*>(&result));
+  return result;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef CULLING_HPP
+#define CULLING_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// six planes bounding the visible volume, normals point inwards
+// order: left, right, bottom, top, near, far
+struct frustum {
+  glm::fvec4 planes[6];
+};
+
+// axis aligned boxes stored as structure of arrays for batched tests
+struct bounding_boxes {
+  void resize(std::size_t count);
+  void set(std::size_t index, glm::fvec3 const& box_min, glm::fvec3 const& box_max);
+  std::size_t size() const;
+
+  std::vector<float> min_x;
+  std::vector<float> min_y;
+  std::vector<float> min_z;
+  std::vector<float> max_x;
+  std::vector<float> max_y;
+  std::vector<float> max_z;
+};
+
+// extract normalized planes from a combined projection and view matrix
+frustum extract_frustum(glm::fmat4 const& view_projection);
+
+// test boxes [first, last) in batches of four and append the indices of the potentially visible ones
+// to visible, conservative near corners, returns number of appended indices
+std::size_t cull_boxes(frustum const& volume, bounding_boxes const& boxes, std::size_t first, std::size_t last,
+                       std::vector<std::uint32_t>& visible);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// bump allocator for transient data that lives at most until the end of the frame
+// allocation is a pointer increment, freeing happens all at once in reset
+class frame_arena {
+ public:
+  explicit frame_arena(std::size_t capacity);
+
+  // memory is valid until the next reset, never returns null
+  void* allocate(std::size_t bytes, std::size_t alignment);
+  // release all allocations, overflowing frames grow the arena so later frames fit in one block
+  void reset();
+
+  // bytes allocated since the last reset
+  std::size_t used() const;
+  // largest used() before any reset
+  std::size_t peak() const;
+  std::size_t capacity() const;
+
+ private:
+  // allocations that do not fit into the main block go into extra blocks until the next reset
+  std::unique_ptr<unsigned char[]> m_block;
+  std::vector<std::unique_ptr<unsigned char[]>> m_overflow;
+  std::size_t m_capacity;
+  std::size_t m_offset;
+  std::size_t m_overflow_offset;
+  std::size_t m_overflow_capacity;
+  std::size_t m_used;
+  std::size_t m_peak;
+};
+
+// arena of the calling thread, reset by the launcher after every frame,
+// only use from the main thread and the render thread
+frame_arena& frame_memory();
+
+// stl allocator drawing from the frame arena, deallocation is a no-op
+template<typename T>
+class frame_allocator {
+ public:
+  typedef T value_type;
+
+  frame_allocator()
+   :m_arena{&frame_memory()}
+  {}
+  explicit frame_allocator(frame_arena& arena)
+   :m_arena{&arena}
+  {}
+  template<typename U>
+  frame_allocator(frame_allocator<U> const& other)
+   :m_arena{other.arena()}
+  {}
+
+  T* allocate(std::size_t count) {
+    return static_cast<T*>(m_arena->allocate(sizeof(T) * count, alignof(T)));
+  }
+  void deallocate(T*, std::size_t) {}
+
+  frame_arena* arena() const {
+    return m_arena;
+  }
+
+ private:
+  frame_arena* m_arena;
+};
+
+template<typename T, typename U>
+bool operator==(frame_allocator<T> const& a, frame_allocator<U> const& b) {
+  return a.arena() == b.arena();
+}
+
+template<typename T, typename U>
+bool operator!=(frame_allocator<T> const& a, frame_allocator<U> const& b) {
+  return a.arena() != b.arena();
+}
+
+// containers for per frame data, must not outlive the frame
+template<typename T>
+using frame_vector = std::vector<T, frame_allocator<T>>;
+typedef std::basic_string<char, std::char_traits<char>, frame_allocator<char>> frame_string;
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+
+#include "job_system.hpp"
+#include "pixel_data.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// records rendered frames without stalling the gl thread
+// pixels are read into a ring of pixel pack buffers, copied out once their fence signaled
+// and encoded on the job system
+class frame_capture {
+ public:
+  enum format {
+    // one png file per frame, named prefix + frame number + .png
+    PNG,
+    // frames appended to one file as top to bottom GL_RGBA rows, readable as rawvideo by ffmpeg
+    RAW
+  };
+
+  // path is the file name prefix for png and the file name for raw video
+  frame_capture(std::string const& path, format encoding, unsigned ring_size = 3);
+  // waits for all captured frames to be written
+  ~frame_capture();
+  frame_capture(frame_capture const&) = delete;
+  frame_capture& operator=(frame_capture const&) = delete;
+
+  // queue readback of the current read framebuffer, call after rendering and before the swap
+  // only waits for a readback if the ring is full, a size change first finishes all captured frames
+  void capture(int width, int height);
+  // read back and encode all queued frames
+  void finish();
+
+  // frames passed to capture
+  std::size_t captured_frames() const;
+  // frames whose readback had to wait for the gpu, a larger ring avoids these stalls
+  std::size_t stalled_frames() const;
+
+ private:
+  struct readback {
+    GLuint buffer;
+    // null while the buffer holds no pending frame
+    GLsync fence;
+    std::size_t frame;
+  };
+
+  // copy out the finished readback and start its encoding, returns false if it is not finished and wait is false
+  bool collect(readback& slot, bool wait);
+  // encode one frame on a worker thread, image rows are still bottom to top
+  void encode(std::shared_ptr<pixel_data> image, std::size_t frame);
+  std::shared_ptr<pixel_data> acquire_image();
+  void release_image(std::shared_ptr<pixel_data> const& image);
+
+  std::string m_path;
+  format m_format;
+  std::ofstream m_video;
+  int m_width;
+  int m_height;
+  std::vector<readback> m_ring;
+  // slot the next frame is read into, also the oldest pending one
+  std::size_t m_next;
+  std::size_t m_captured;
+  std::size_t m_stalled;
+
+  // running encodings in submission order, limited to keep memory bounded
+  std::deque<job_system::job_handle> m_encodes;
+  // raw frames are appended by a chain of jobs, each depends on the previous one
+  job_system::job_handle m_last_write;
+  // images of finished encodings, reused for the next frames
+  std::mutex m_pool_mutex;
+  std::vector<std::shared_ptr<pixel_data>> m_pool;
+};
+
+// png with uncompressed deflate blocks, first row is the top
+void write_png(std::string const& file_name, pixel_data const& image);
+
+#endif
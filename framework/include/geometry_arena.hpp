@@ -0,0 +1,103 @@
+#ifndef GEOMETRY_ARENA_HPP
+#define GEOMETRY_ARENA_HPP
+
+#include "asset_memory.hpp"
+#include "model.hpp"
+#include "vertex_layout.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <ostream>
+#include <vector>
+
+// vertex and index ranges of all meshes with the same vertex layout in one shared buffer each,
+// so they are drawn with a single vertex array object and base vertex offsets
+class geometry_arena {
+ public:
+  // location of a mesh in the shared buffers
+  struct mesh_range {
+    // added to every index of the mesh
+    GLint base_vertex;
+    GLsizei vertex_count;
+    std::size_t first_index;
+    GLsizei index_count;
+  };
+
+  // fill level of the buffers, fragmentation is the share of free space outside the largest free block
+  struct usage {
+    std::size_t vertices_used;
+    std::size_t vertex_capacity;
+    std::size_t indices_used;
+    std::size_t index_capacity;
+    std::size_t free_blocks;
+    float vertex_fragmentation;
+    float index_fragmentation;
+  };
+
+  // attributes of the layout are bound to consecutive locations, only models with exactly these attributes can be added
+  template<typename Layout>
+  geometry_arena(Layout, std::size_t vertex_capacity, std::size_t index_capacity)
+   :geometry_arena{Layout::flags, Layout::stride, vertex_capacity, index_capacity}
+  {
+    static_assert(is_model_layout<Layout>::value, "geometry arena layout must only contain model attributes in model order");
+    // the buffers are still bound after the delegated constructor
+    enable_vertex_attributes<Layout>();
+    set_vertex_attributes<Layout>();
+  }
+  ~geometry_arena();
+  geometry_arena(geometry_arena const&) = delete;
+  geometry_arena& operator=(geometry_arena const&) = delete;
+
+  // copy mesh into free ranges, throws if the layout differs or the arena is full
+  mesh_range add(model const& mesh);
+  // release ranges of a mesh for reuse
+  void remove(mesh_range const& range);
+
+  // shared vertex array object, must be bound for drawing
+  GLuint vertex_array() const;
+  // draw the mesh with the bound program
+  void draw(mesh_range const& range, GLenum mode = GL_TRIANGLES) const;
+  void draw_instanced(mesh_range const& range, GLsizei instances, GLenum mode = GL_TRIANGLES) const;
+
+  // gpu bytes of the vertex and index ranges of a mesh
+  std::size_t bytes(mesh_range const& range) const;
+
+  usage report() const;
+  void print_usage(std::ostream& stream) const;
+
+ private:
+  // creates and binds the vertex array and both buffers, attributes are set by the layout constructor
+  geometry_arena(model::attrib_flag_t attributes, std::size_t vertex_bytes, std::size_t vertex_capacity, std::size_t index_capacity);
+
+  // contiguous free range in elements
+  struct block {
+    std::size_t first;
+    std::size_t count;
+  };
+
+  // first fit allocation, returns false if no block is large enough
+  static bool allocate(std::vector<block>& free_blocks, std::size_t count, std::size_t& first);
+  // insert range sorted by position and merge it with adjacent free blocks
+  static void release(std::vector<block>& free_blocks, std::size_t first, std::size_t count);
+  static float fragmentation(std::vector<block> const& free_blocks);
+  static std::size_t free_space(std::vector<block> const& free_blocks);
+  // report the unused capacity to the asset accounting
+  void update_asset() const;
+
+  model::attrib_flag_t m_attributes;
+  GLsizei m_vertex_bytes;
+  std::size_t m_vertex_capacity;
+  std::size_t m_index_capacity;
+  GLuint m_vertex_array;
+  GLuint m_vertex_buffer;
+  GLuint m_element_buffer;
+  // sorted by position
+  std::vector<block> m_free_vertices;
+  std::vector<block> m_free_indices;
+  // counts the free capacity of both buffers, ranges in use are counted by the owners of the meshes
+  asset_memory::handle m_asset;
+};
+
+#endif
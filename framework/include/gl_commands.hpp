@@ -0,0 +1,13 @@
+#ifndef GL_COMMANDS_HPP
+#define GL_COMMANDS_HPP
+
+#include "command_buffer.hpp"
+
+// opengl backend of the command buffers, must run on the thread owning the context
+namespace gl_commands {
+  void execute(command_buffer const& commands);
+  // buffers are executed in stream order
+  void execute(command_stream const& stream);
+}
+
+#endif
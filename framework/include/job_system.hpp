@@ -0,0 +1,117 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// work stealing thread pool, every worker owns a deque and steals from the others when it runs dry
+// jobs must not throw
+class job_system {
+ public:
+  struct job;
+  // finished once the job has run, can be waited on and used as dependency
+  typedef std::shared_ptr<job> job_handle;
+
+  // worker_count 0 uses one worker less than hardware threads, as waiting threads help executing jobs
+  explicit job_system(unsigned worker_count = 0);
+  ~job_system();
+
+  // pool shared by the framework, created on first use
+  static job_system& instance();
+
+  // run work on any thread after all dependencies finished
+  job_handle submit(std::function<void()> work, std::vector<job_handle> const& dependencies = std::vector<job_handle>{});
+  // run work in run_main_jobs after all dependencies finished, for gl calls
+  job_handle submit_main(std::function<void()> work, std::vector<job_handle> const& dependencies = std::vector<job_handle>{});
+  // execute other jobs until the given one finished
+  void wait(job_handle const& handle);
+  bool finished(job_handle const& handle) const;
+  // execute ready main thread jobs, only call from the main thread
+  std::size_t run_main_jobs();
+  // make the calling thread the main thread, e.g. a render thread owning the gl context
+  void set_main_thread();
+
+  // number of threads executing jobs including a waiting caller
+  unsigned concurrency() const;
+
+ private:
+  // jobs of one thread, the owner works at the back, thieves take from the front
+  struct job_queue {
+    std::mutex mutex;
+    std::deque<job_handle> jobs;
+  };
+
+  job_handle create(std::function<void()> work, bool main_thread, std::vector<job_handle> const& dependencies);
+  // enqueue job whose dependencies are finished
+  void schedule(job_handle const& handle);
+  // run job and release the jobs depending on it
+  void execute(job_handle const& handle);
+  // run one job from the own queue or a stolen one, returns whether one was run
+  bool run_one();
+  // queue of the calling thread, threads outside of the pool share the first one
+  std::size_t queue_index() const;
+  void worker_loop(std::size_t index);
+
+  std::vector<std::unique_ptr<job_queue>> m_queues;
+  std::vector<std::thread> m_workers;
+  // thread running main thread jobs, the creator until set_main_thread is called
+  std::atomic<std::thread::id> m_main_thread;
+
+  // jobs that must run on the main thread
+  std::mutex m_main_mutex;
+  std::vector<job_handle> m_main_jobs;
+
+  // idle workers sleep until jobs are queued
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_wake;
+  std::atomic<std::size_t> m_queued;
+  std::atomic<bool> m_stop;
+};
+
+struct job_system::job {
+  std::function<void()> work;
+  bool main_thread;
+  // unfinished dependencies, plus one while the job is being submitted
+  std::atomic<unsigned> pending;
+  std::atomic<bool> done;
+  // guards continuations against concurrent completion
+  std::mutex mutex;
+  std::vector<job_handle> continuations;
+};
+
+// call function(first, last) for consecutive chunks of [begin, end) of at least grain indices in parallel,
+// returns once all chunks finished
+template<typename F>
+void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, F const& function) {
+  if (end <= begin) {
+    return;
+  }
+  grain = std::max(grain, std::size_t(1));
+  // single chunks run directly without scheduling overhead
+  if (end - begin <= grain) {
+    function(begin, end);
+    return;
+  }
+  job_system& jobs = job_system::instance();
+  std::vector<job_system::job_handle> chunks{};
+  for (std::size_t first = begin + grain; first < end; first += grain) {
+    std::size_t last = std::min(first + grain, end);
+    chunks.push_back(jobs.submit([&function, first, last]() {
+      function(first, last);
+    }));
+  }
+  // calling thread processes the first chunk
+  function(begin, begin + grain);
+  for (auto const& chunk : chunks) {
+    jobs.wait(chunk);
+  }
+}
+
+#endif
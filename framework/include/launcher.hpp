@@ -2,8 +2,15 @@
 #define LAUNCHER_HPP
 
 #include "application.hpp"
+#include "benchmark.hpp"
+#include "frame_capture.hpp"
 
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 // forward declarations
 class Application;
@@ -20,6 +27,8 @@ class Launcher {
  private:
 
   Launcher(int argc, char* argv[]);
+  // read resource path and launch options from command line
+  void parse_arguments(int argc, char* argv[]);
   // run application
   template<typename T>
   void run(){
@@ -32,34 +41,112 @@ class Launcher {
   
   // create window and set callbacks
   void initialize();
+  // create offscreen framebuffer for headless rendering
+  void create_framebuffer();
+  // get size of the framebuffer that is rendered to
+  void get_framebuffer_size(int& width, int& height) const;
   // start main loop
   void mainLoop();
+  // simulate on this thread while a render thread draws the previous frame
+  void threaded_loop();
+  // body of the render thread, renders the latest published frame
+  void render_loop();
+  // clear, render and present one frame, fills the render and present times of the sample
+  void render_frame(benchmark::frame_sample& sample);
+  // run gl work now, or queue it for the render thread if there is one
+  void on_gl_thread(std::function<void()> const& work);
   // update viewport and field of view
   void update_projection(GLFWwindow* window, int width, int height);
-  // load shader programs and update uniform locations
+  // load shader programs and update uniform locations, projection must be updated afterwards
   void update_shader_programs(bool throwing);
   // handle key input
   void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
   // handle mouse scroll
   void mouse_scroll_callback(GLFWwindow* window, double x, double y);
   // calculate fps and show in window title
-  void show_fps();
+  void show_fps(double current_time);
+  // write statistics of recorded frames as json
+  void write_report() const;
+  // run as many fixed simulation steps as the elapsed frame time requires
+  void update_simulation(double frame_time);
+  // dispatch recorded key events of the current frame
+  void replay_input();
   // free resources
   void quit(int status);
 
   // vertical field of view of camera
   const float m_camera_fov;
 
-  // initial window dimensions
-  const unsigned m_window_width;
-  const unsigned m_window_height;
+  // initial window dimensions, offscreen resolution when headless
+  unsigned m_window_width;
+  unsigned m_window_height;
   // the rendering window
   GLFWwindow* m_window;
 
+  // render into hidden window and offscreen framebuffer
+  bool m_headless;
+  // number of frames to render before quitting, 0 means unlimited
+  unsigned m_frame_limit;
+  // offscreen framebuffer and its attachments
+  unsigned m_framebuffer;
+  unsigned m_color_buffer;
+  unsigned m_depth_buffer;
+  // timings of each rendered frame, recorded when frame limit is set
+  std::vector<benchmark::frame_sample> m_frame_samples;
+  // number of draw calls issued in current frame
+  unsigned m_draw_calls;
+  // advance simulation by exactly one step per frame for reproducible runs
+  bool m_fixed_clock;
+  // render on a separate thread, simulation and input stay on the main thread
+  bool m_render_thread;
+  // frames published by the main thread and acquired by the render thread,
+  // the lock only wakes and paces the threads, the snapshots are handed over without it
+  std::mutex m_frame_mutex;
+  std::condition_variable m_frame_signal;
+  unsigned m_published_frames;
+  unsigned m_acquired_frames;
+  // whether the main thread waits until each frame is acquired, otherwise it simulates ahead
+  // and frames replaced before the render thread got to them are skipped
+  bool m_lockstep;
+  bool m_simulation_done;
+  // poll and update times of the main thread, merged into the frame samples
+  std::vector<benchmark::frame_sample> m_simulation_samples;
+  // largest frame memory use of the render thread
+  std::size_t m_render_memory_peak;
+  // file prefix or video file rendered frames are written to, no capture if empty
+  std::string m_capture_path;
+  frame_capture::format m_capture_format;
+  std::unique_ptr<frame_capture> m_capture;
+  // size of the rendered frames, only used on the gl thread
+  int m_framebuffer_width;
+  int m_framebuffer_height;
+  // index of current frame
+  unsigned m_frame_index;
+  // key events to replay and the next one to dispatch
+  std::vector<benchmark::input_event> m_input_timeline;
+  std::size_t m_next_input;
+  // files to write recorded key events and json report to, stdout if report is empty
+  std::string m_record_path;
+  std::string m_report_path;
+  // recorded key events
+  std::vector<benchmark::input_event> m_recorded_input;
+
   // variables for fps computation
   double m_last_second_time;
   unsigned m_frames_per_second;
 
+  // variables for fixed timestep simulation
+  // simulated seconds per update step
+  const double m_time_step;
+  // upper bound for elapsed time of a single frame, prevents spiral of death
+  const double m_max_frame_time;
+  // upper bound of update steps per frame, excess simulation time is dropped
+  const unsigned m_max_steps;
+  // factor between real and simulated time
+  double m_time_scale;
+  // simulated time not yet consumed by update steps
+  double m_time_accumulator;
+
   // path to the resource folders
   std::string m_resource_path;
 
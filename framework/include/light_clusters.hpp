@@ -0,0 +1,68 @@
+#ifndef LIGHT_CLUSTERS_HPP
+#define LIGHT_CLUSTERS_HPP
+
+#include "bvh.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// point light in view space, reaches everything inside its radius
+struct point_light {
+  glm::fvec3 position;
+  float radius;
+  glm::fvec3 color;
+  float intensity;
+};
+
+// view frustum split into tiles_x * tiles_y * slices clusters for clustered forward shading
+// slices are spaced exponentially in depth, so clusters keep their proportions far away
+// every cluster lists the lights whose sphere touches it, slices are assigned in parallel on the job system
+class light_clusters {
+ public:
+  // part of the index list belonging to one cluster
+  struct range {
+    std::uint32_t first;
+    std::uint32_t count;
+  };
+
+  light_clusters(unsigned tiles_x, unsigned tiles_y, unsigned slices);
+
+  // recompute the cluster bounds for a perspective projection, needed whenever it changes
+  void set_projection(glm::fmat4 const& projection);
+  // rebuild the lists for lights in view space, using at most the given number of jobs, 0 uses the whole job system
+  void assign(std::vector<point_light> const& lights, unsigned threads = 0);
+
+  // one range per cluster, x varies fastest, then y, then the slice
+  std::vector<range> const& ranges() const;
+  // light indices of all clusters, back to back
+  std::vector<std::uint32_t> const& indices() const;
+  // tiles in x and y and slices
+  glm::fvec3 grid() const;
+  // slice of a fragment is log(view depth) * scale + bias
+  glm::fvec2 depth_mapping() const;
+  std::size_t cluster_count() const;
+  // longest list of the last assignment
+  std::size_t max_lights_per_cluster() const;
+
+ private:
+  // fills the ranges of one slice and its part of the index list
+  void assign_slice(std::size_t slice, std::vector<point_light> const& lights);
+
+  unsigned m_tiles_x;
+  unsigned m_tiles_y;
+  unsigned m_slices;
+  float m_near;
+  float m_far;
+  // view space bounds of every cluster, in the order of the ranges
+  std::vector<aabb> m_bounds;
+  std::vector<range> m_ranges;
+  // per slice lists with indices starting at zero, joined after all slices are done
+  std::vector<std::vector<std::uint32_t>> m_slice_indices;
+  // scratch lists of the lights overlapping each slice, kept to reuse allocations
+  std::vector<std::vector<std::uint32_t>> m_slice_candidates;
+  std::vector<std::uint32_t> m_indices;
+};
+
+#endif
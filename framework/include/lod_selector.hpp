@@ -0,0 +1,29 @@
+#ifndef LOD_SELECTOR_HPP
+#define LOD_SELECTOR_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <vector>
+
+// picks a level of detail from the projected size of an object, levels are ordered from coarse to fine
+// a level is only left once the size passes its threshold by the hysteresis margin, so objects near a threshold keep their level
+class lod_selector {
+ public:
+  // thresholds[i] is the projected size from which level i + 1 is used, must be ascending
+  // hysteresis is the relative margin around every threshold
+  lod_selector(std::vector<float> thresholds, float hysteresis = 0.2f);
+
+  // level for the projected size of an object that was drawn with the current level
+  unsigned select(float projected_size, unsigned current) const;
+  unsigned levels() const;
+
+  // diameter of a sphere as fraction of the viewport height under a perspective projection
+  // returns a huge value if the eye is inside the sphere
+  static float projected_size(glm::fmat4 const& projection, float distance, float radius);
+
+ private:
+  std::vector<float> m_thresholds;
+  float m_hysteresis;
+};
+
+#endif
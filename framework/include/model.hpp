@@ -3,7 +3,8 @@
 
 #include <glbinding/gl/types.h>
 
-#include <map>
+#include <glm/gtc/type_precision.hpp>
+
 #include <vector>
 // use gl definitions from glbinding 
 using namespace gl;
@@ -54,13 +55,28 @@ struct model {
   model();
   model(std::vector<GLfloat> const& databuff, attrib_flag_t attribs, std::vector<GLuint> const& trianglebuff = std::vector<GLuint>{});
 
+  // byte offset of an attribute inside a vertex, the attribute must be contained
+  std::size_t offset(attribute const& attrib) const;
+
+  // bytes held by the vertex and index vectors
+  std::size_t cpu_bytes() const;
+  // free vertex and index data once uploaded, layout, counts and bounds stay valid
+  void release_cpu_copy();
+
   std::vector<GLfloat> data;
   std::vector<GLuint> indices;
-  // byte offsets of individual element attributes
-  std::map<attrib_flag_t, GLvoid*> offsets;
+  // contained attributes, interleaved in the order of VERTEX_ATTRIBS
+  attrib_flag_t attributes;
   // size of one vertex element in bytes
   GLsizei vertex_bytes;
   std::size_t vertex_num;
+
+  // axis aligned bounding box in model space
+  glm::fvec3 box_min;
+  glm::fvec3 box_max;
+  // bounding sphere in model space
+  glm::fvec3 sphere_center;
+  float sphere_radius;
 };
 
 #endif
\ No newline at end of file
@@ -9,6 +9,9 @@ namespace model_loader {
 
 model obj(std::string const& path, model::attrib_flag_t import_attribs = model::POSITION);
 
+// compute bounding box and sphere from vertex positions
+void compute_bounds(model& mesh);
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+#ifndef NBODY_HPP
+#define NBODY_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// point masses under mutual gravity as structure of arrays
+struct nbody_system {
+  // returns body index
+  std::size_t add(glm::fvec3 const& position, glm::fvec3 const& velocity, float mass);
+  std::size_t size() const;
+
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  std::vector<float> vx;
+  std::vector<float> vy;
+  std::vector<float> vz;
+  // result of the last force evaluation
+  std::vector<float> ax;
+  std::vector<float> ay;
+  std::vector<float> az;
+  std::vector<float> mass;
+};
+
+struct gravity_settings {
+  // gravitational constant in the unit system of the bodies
+  float gravity = 1.0f;
+  // softening length, its square is added to squared distances to limit forces in close encounters
+  float softening = 0.01f;
+  // node size to distance ratio below which a node is approximated by its center of mass, 0 is exact
+  float opening_angle = 0.5f;
+  // maximum number of parallel force evaluation jobs, 0 uses the whole job system
+  unsigned threads = 0;
+};
+
+// octree over the bodies, approximates distant groups by their center of mass
+class barnes_hut {
+ public:
+  barnes_hut();
+
+  // rebuild tree for current positions
+  void build(nbody_system const& bodies);
+  // write accelerations of all bodies from the last built tree into ax, ay, az
+  void accelerate(nbody_system& bodies, gravity_settings const& settings) const;
+
+  std::size_t node_count() const;
+
+ private:
+  struct node {
+    glm::fvec3 center_of_mass;
+    float mass;
+    glm::fvec3 center;
+    float half_size;
+    // first child for inner nodes, first body in tree order for leaves
+    std::uint32_t first;
+    // number of bodies in a leaf
+    std::uint32_t count;
+    // number of children, zero for leaves
+    std::uint32_t children;
+  };
+
+  void build_node(std::uint32_t node_index, std::uint32_t first, std::uint32_t count, unsigned depth);
+  // accelerations of the bodies at tree order positions [first, last)
+  void accelerate_range(nbody_system& bodies, gravity_settings const& settings, std::size_t first, std::size_t last) const;
+
+  std::vector<node> m_nodes;
+  // body indices in tree order, leaves reference contiguous ranges
+  std::vector<std::uint32_t> m_order;
+  // position and mass of the bodies in input order and in tree order for contiguous leaf access
+  std::vector<glm::fvec4> m_source;
+  std::vector<glm::fvec4> m_points;
+  std::vector<std::uint32_t> m_scratch;
+};
+
+// advance by one kick-drift-kick leapfrog step, accelerations must be valid for the current positions,
+// e.g. from an initial build and accelerate, and are valid again afterwards
+void leapfrog_step(nbody_system& bodies, barnes_hut& tree, gravity_settings const& settings, float delta_time);
+
+// add bodies on circular orbits in a ring around a central mass, reproducible for a seed
+void add_ring(nbody_system& bodies, std::uint32_t seed, std::size_t count, glm::fvec3 const& center, glm::fvec3 const& center_velocity,
+              float central_mass, float inner_radius, float outer_radius, float thickness, float body_mass, float gravity);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef OCCLUSION_HPP
+#define OCCLUSION_HPP
+
+#include "bvh.hpp"
+#include "raster_triangle.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// low resolution software depth buffer of a few large occluders,
+// boxes are tested against a pyramid holding the farthest depth of each region
+class occlusion_buffer {
+ public:
+  // width is rounded up to a multiple of four
+  occlusion_buffer(std::size_t width = 256, std::size_t height = 128);
+
+  // drop occluders of the last frame and set the combined projection and view matrix
+  void begin(glm::fmat4 const& view_projection);
+  // set up triangles of an occluder, positions of consecutive vertices are stride floats apart,
+  // triangles crossing the near plane are skipped
+  void add_occluder(glm::fmat4 const& model_matrix, float const* positions, std::size_t vertex_count, std::size_t stride,
+                    std::uint32_t const* indices, std::size_t index_count);
+  // rasterize all occluders in parallel row bands and build the depth pyramid,
+  // threads limits the number of bands, 0 uses the whole job system
+  void finish(unsigned threads = 0);
+
+  // whether the box may be visible, boxes crossing the near plane always are
+  bool visible(aabb const& box) const;
+  // remove indices of occluded boxes, keeps the order, returns remaining count
+  std::size_t cull(std::vector<aabb> const& boxes, std::vector<std::uint32_t>& indices) const;
+
+  std::size_t width() const;
+  std::size_t height() const;
+  // depth in [0, 1] of the finest level, row 0 is the top of the screen
+  std::vector<float> const& depth() const;
+  std::size_t triangle_count() const;
+
+ private:
+  // rasterize all triangles overlapping rows [first_row, last_row)
+  void rasterize(std::size_t first_row, std::size_t last_row);
+  void build_pyramid();
+
+  std::size_t m_width;
+  std::size_t m_height;
+  glm::fmat4 m_view_projection;
+  std::vector<raster_triangle> m_triangles;
+  // screen space vertices of the occluder being added, x and y in pixels, z is depth
+  std::vector<glm::fvec3> m_screen;
+  std::vector<std::uint8_t> m_clipped;
+  // level 0 is the full resolution depth, every further level halves both dimensions
+  std::vector<std::vector<float>> m_levels;
+  std::vector<std::size_t> m_level_widths;
+  std::vector<std::size_t> m_level_heights;
+};
+
+#endif
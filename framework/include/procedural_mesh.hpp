@@ -0,0 +1,12 @@
+#ifndef PROCEDURAL_MESH_HPP
+#define PROCEDURAL_MESH_HPP
+
+#include "model.hpp"
+
+// unit sphere from a cube whose faces are split into subdivisions x subdivisions quads, 12 * subdivisions^2 triangles
+// grid lines are spaced by angle, so triangles have nearly equal size
+// normals and spherical texture coordinates are added if requested, the seam lies on grid lines
+// throws if subdivisions is zero or odd
+model cube_sphere(unsigned subdivisions, model::attrib_flag_t attributes = model::POSITION);
+
+#endif
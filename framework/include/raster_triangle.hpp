@@ -0,0 +1,33 @@
+#ifndef RASTER_TRIANGLE_HPP
+#define RASTER_TRIANGLE_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstddef>
+
+// screen space triangle prepared for the software rasterizers,
+// edge functions and depth are planes value = c + dx * x + dy * y,
+// edges are stored by component, depth as (c, dx, dy)
+struct raster_triangle {
+  // inclusive pixel bounds, clamped to the target
+  int min_x;
+  int max_x;
+  int min_y;
+  int max_y;
+  glm::fvec3 edge_c;
+  glm::fvec3 edge_dx;
+  glm::fvec3 edge_dy;
+  glm::fvec3 depth;
+};
+
+// set up bounds, edges and depth of a triangle in a width x height target, corners have x and y in pixels and depth in z,
+// both windings are accepted, order receives the corner indices with positive area and area the doubled area,
+// returns false if the triangle covers no pixel center worth rasterizing
+bool setup_raster_triangle(glm::fvec3 const (&corners)[3], std::size_t width, std::size_t height,
+                           raster_triangle& result, int (&order)[3], float& area);
+
+// plane through three values at the corners in the order of setup_raster_triangle, as (c, dx, dy)
+glm::fvec3 raster_plane(glm::fvec3 const& p0, glm::fvec3 const& p1, glm::fvec3 const& p2, float area,
+                        float f0, float f1, float f2);
+
+#endif
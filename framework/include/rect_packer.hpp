@@ -0,0 +1,41 @@
+#ifndef RECT_PACKER_HPP
+#define RECT_PACKER_HPP
+
+#include <cstddef>
+#include <vector>
+
+// places rectangles into a fixed area, bottom left skyline heuristic
+// the skyline is the upper edge of the filled area, space below it is never reused
+class rect_packer {
+ public:
+  rect_packer(std::size_t width, std::size_t height);
+
+  // lowest free position for a rectangle of the given size, false if it does not fit anymore
+  bool insert(std::size_t width, std::size_t height, std::size_t& x, std::size_t& y);
+  // remove all rectangles
+  void clear();
+
+  std::size_t width() const;
+  std::size_t height() const;
+  // share of the area covered by inserted rectangles
+  float occupancy() const;
+
+ private:
+  // horizontal piece of the skyline
+  struct segment {
+    std::size_t x;
+    std::size_t y;
+    std::size_t width;
+  };
+
+  // height a rectangle would be placed at when starting at the given segment, false if it does not fit
+  bool fit(std::size_t index, std::size_t width, std::size_t height, std::size_t& y) const;
+
+  std::size_t m_width;
+  std::size_t m_height;
+  std::size_t m_used_area;
+  // sorted by x, covers the whole width
+  std::vector<segment> m_skyline;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef SCENE_GRAPH_HPP
+#define SCENE_GRAPH_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// transform hierarchy stored in flat arrays, parents always precede their children
+class scene_graph {
+ public:
+  // parent index of root nodes
+  static const int NO_PARENT = -1;
+
+  scene_graph();
+
+  // append node below parent and return its index
+  std::size_t add_node(int parent, glm::fmat4 const& local = glm::fmat4{});
+  // change transform relative to parent, marks node dirty
+  void set_local(std::size_t node, glm::fmat4 const& local);
+
+  // recompute world and normal matrices of dirty nodes and their descendants
+  // returns the number of recomputed nodes
+  std::size_t update();
+
+  int parent(std::size_t node) const;
+  glm::fmat4 const& local(std::size_t node) const;
+  // transform to world space, valid after update
+  glm::fmat4 const& world(std::size_t node) const;
+  // inverse transpose of world matrix for transforming normals, valid after update
+  glm::fmat4 const& normal(std::size_t node) const;
+  std::size_t size() const;
+
+ private:
+  std::vector<int> m_parents;
+  std::vector<glm::fmat4> m_locals;
+  std::vector<glm::fmat4> m_worlds;
+  std::vector<glm::fmat4> m_normals;
+  // local transform changed since last update
+  std::vector<std::uint8_t> m_dirty;
+  // update pass in which the world matrix was last recomputed
+  std::vector<unsigned> m_updated;
+  // current update pass
+  unsigned m_pass;
+  // lowest dirty index, nodes before it are unaffected
+  std::size_t m_first_dirty;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef SOFTWARE_RENDERER_HPP
+#define SOFTWARE_RENDERER_HPP
+
+#include "model.hpp"
+#include "pixel_data.hpp"
+#include "raster_triangle.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// cpu replacement for the gl pipeline of the planet shader, for machines without gpu
+// triangles are binned into screen tiles, tiles are rasterized in parallel on the job system
+class software_renderer {
+ public:
+  software_renderer(std::size_t width, std::size_t height);
+
+  // set matrices used by following draws, same meaning as the shader uniforms
+  void set_camera(glm::fmat4 const& view_matrix, glm::fmat4 const& projection_matrix);
+  // reset color and depth, depth is cleared to the far plane
+  void clear(glm::fvec4 const& color);
+  // queue triangles of the model, shaded like the unlit simple.frag with the view space normal and a white surface,
+  // the model is read in finish and must stay alive until then
+  void draw(model const& mesh, glm::fmat4 const& model_matrix, glm::fmat4 const& normal_matrix);
+  // rasterize all queued triangles, threads limits the number of parallel jobs, 0 uses the whole job system
+  void finish(unsigned threads = 0);
+
+  // color buffer as GL_RGBA bytes, first row is the top of the image
+  pixel_data image() const;
+  // depth in [0, 1] with stride width rounded up to four
+  std::vector<float> const& depth() const;
+  std::size_t width() const;
+  std::size_t height() const;
+  // triangles of the last finish after clipping and culling of degenerate ones
+  std::size_t triangle_count() const;
+
+ private:
+  // vertex after the vertex stage, normal is in view space
+  struct clip_vertex {
+    glm::fvec4 position;
+    glm::fvec3 normal;
+  };
+  // raster triangle with attribute planes as (c, dx, dy),
+  // normals are interpolated divided by w and corrected with the interpolated 1 / w
+  struct triangle : raster_triangle {
+    glm::fvec3 inverse_w;
+    glm::fvec3 normal[3];
+  };
+
+  struct draw_call {
+    model const* mesh;
+    glm::fmat4 model_view_projection;
+    // normal matrix followed by the view matrix
+    glm::fmat4 view_normal;
+    // position of the first vertex in m_vertices
+    std::size_t first_vertex;
+  };
+  // consecutive triangles of one draw, set up and binned by one job
+  struct chunk {
+    std::size_t draw;
+    std::size_t first_triangle;
+    std::size_t last_triangle;
+    std::vector<triangle> triangles;
+    // indices into triangles for every tile
+    std::vector<std::vector<std::uint32_t>> bins;
+  };
+
+  void transform_vertices(draw_call const& call, std::size_t first, std::size_t last);
+  // clip against the near plane and set up the resulting triangles
+  void add_triangle(chunk& target, clip_vertex const& a, clip_vertex const& b, clip_vertex const& c) const;
+  void setup_triangle(chunk& target, clip_vertex const& a, clip_vertex const& b, clip_vertex const& c) const;
+  // set up triangles of the chunk and sort them into the tiles they overlap
+  void bin(chunk& target) const;
+  void rasterize_tile(std::size_t tile);
+
+  std::size_t m_width;
+  std::size_t m_height;
+  // row length of the buffers, multiple of four
+  std::size_t m_stride;
+  std::size_t m_tiles_x;
+  std::size_t m_tiles_y;
+  glm::fmat4 m_view;
+  glm::fmat4 m_projection;
+  // packed rgba, red in the lowest byte
+  std::vector<std::uint32_t> m_color;
+  std::vector<float> m_depth;
+  // queued draws, their vertices are transformed in finish
+  std::vector<draw_call> m_draws;
+  // clip space vertices of all draws
+  std::vector<clip_vertex> m_vertices;
+  // chunks are in submission order, so results do not depend on the thread count
+  std::vector<chunk> m_chunks;
+  std::size_t m_chunk_count;
+};
+
+// uncompressed 32 bit tga, readable with texture_loader::file
+void write_tga(std::string const& file_name, pixel_data const& image);
+
+// per channel differences of two GL_RGBA images of equal size
+struct image_difference {
+  // largest difference of a channel in any pixel
+  unsigned max_difference;
+  // pixels with any channel differing by more than the tolerance
+  std::size_t differing_pixels;
+  double mean_difference;
+};
+// throws if formats or sizes differ
+image_difference compare_images(pixel_data const& result, pixel_data const& reference, unsigned tolerance = 0);
+
+#endif
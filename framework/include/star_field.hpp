@@ -0,0 +1,27 @@
+#ifndef STAR_FIELD_HPP
+#define STAR_FIELD_HPP
+
+#include <cstdint>
+#include <vector>
+
+// compact star vertex of 16 bytes
+struct star_point {
+  float x;
+  float y;
+  float z;
+  // rgb colour in the lower bytes, brightness from the magnitude in the highest byte
+  std::uint32_t color;
+};
+
+// counter based random number, the same seed and counter always give the same value
+std::uint32_t random_hash(std::uint32_t seed, std::uint32_t counter);
+// random float in [0, 1)
+float random_unit(std::uint32_t seed, std::uint32_t counter);
+
+// fill stars with indices [first, first + count) of the field, result does not depend on partitioning
+void generate_stars(std::uint32_t seed, std::size_t first, std::size_t count, float extent, star_point* stars);
+// stars uniformly distributed in a cube with the given half extent, generated by at most
+// the given number of jobs in parallel, 0 uses the whole job system
+std::vector<star_point> generate_star_field(std::uint32_t seed, std::size_t count, float extent, unsigned threads = 0);
+
+#endif
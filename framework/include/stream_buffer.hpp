@@ -0,0 +1,61 @@
+#ifndef STREAM_BUFFER_HPP
+#define STREAM_BUFFER_HPP
+
+#include "asset_memory.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <cstddef>
+#include <vector>
+
+// buffer rewritten by the cpu every frame, split into one region per frame in flight
+// mapped persistently if the context supports buffer storage, else each region is mapped unsynchronized
+// fences keep the cpu from writing regions the gpu still reads
+class stream_buffer {
+ public:
+  // part of the current region, pointer is valid until end_writes, any thread may write to it
+  struct allocation {
+    void* data;
+    // offset in the buffer, for attribute pointers or binding ranges
+    GLintptr offset;
+    GLsizeiptr size;
+  };
+
+  // frame_size bytes for each of frames regions
+  stream_buffer(GLenum target, std::size_t frame_size, unsigned frames = 3);
+  ~stream_buffer();
+  stream_buffer(stream_buffer const&) = delete;
+  stream_buffer& operator=(stream_buffer const&) = delete;
+
+  // start writing the next region, waits until the gpu finished reading it
+  void begin_frame();
+  // reserve bytes with the given alignment in the current region, throws if the region is full
+  allocation allocate(std::size_t size, std::size_t alignment = 16);
+  // make written data visible, draws may only read the region afterwards
+  void end_writes();
+  // fence the region, call after the last draw using it
+  void end_frame();
+
+  GLuint handle() const;
+  GLenum target() const;
+  bool persistent() const;
+  // bytes allocated in the current region
+  std::size_t used() const;
+
+ private:
+  GLenum m_target;
+  GLuint m_handle;
+  std::size_t m_frame_size;
+  unsigned m_frames;
+  bool m_persistent;
+  // start of the whole buffer if persistent, else of the mapped region
+  unsigned char* m_mapping;
+  unsigned m_region;
+  std::size_t m_used;
+  std::vector<GLsync> m_fences;
+  asset_memory::handle m_asset;
+};
+
+#endif
@@ -3,8 +3,10 @@
 
 #include <map>
 #include <glbinding/gl/gl.h>
+#include <glm/gtc/type_precision.hpp>
 
 #include "model_loader.hpp"
+#include "command_buffer.hpp"
 
 // use gl definitions from glbinding 
 using namespace gl;
@@ -41,16 +43,13 @@ struct texture_object {
   GLenum target = GL_NONE;
 };
 
-struct planet
-{
-    //std::string name;
-    model planet_model;
-    model_object planet_object;
-    std::string name;               //name just needed for recignition in upload_planet_transforms method
-    float size;                     //scale factor for glm::scale function
-    int speed;                      //value needed for rotation speed: the greater the value the slower the rotation around the Sun
-    float distance;          //distance from origin
-    
+// cpu copy of a uniform value, vectors are stored in the first column
+struct uniform_value {
+  GLint location = -1;
+  bool matrix = false;
+  glm::fmat4 value{};
+  // changed since the last upload, cleared when recording does not change the value
+  mutable bool dirty = true;
 };
 
 // shader handle and uniform storage
@@ -68,5 +67,18 @@ struct shader_program {
   GLuint handle;
   // uniform locations mapped to name
   std::map<std::string, GLint> u_locs{};
+  // last values set for the uniforms, mapped to name
+  std::map<std::string, uniform_value> u_values{};
+
+  // update the shadow copy, only a differing value is uploaded again
+  void set_uniform(std::string const& name, glm::fmat4 const& value);
+  void set_uniform(std::string const& name, glm::fvec4 const& value);
+  // take locations from u_locs and upload all values again, after relinking or location updates
+  void invalidate_uniforms();
+  // record uploads of the changed values, the program must be in use when they are executed
+  void record_uniforms(command_buffer& commands) const;
+
+ private:
+  void store_uniform(std::string const& name, glm::fmat4 const& value, bool matrix);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef TEXTURE_ATLAS_HPP
+#define TEXTURE_ATLAS_HPP
+
+#include "asset_memory.hpp"
+#include "pixel_data.hpp"
+#include "structs.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// surfaces of many objects in one GL_TEXTURE_2D_ARRAY, so instanced draws need no texture switches
+// images of the layer size get a layer of their own, smaller ones are packed into shared atlas layers
+class texture_atlas {
+ public:
+  // where a surface lies in the array, texture coordinates are mapped to offset + uv * scale
+  struct surface {
+    glm::fvec2 offset;
+    glm::fvec2 scale;
+    float layer;
+  };
+
+  texture_atlas();
+  ~texture_atlas();
+  texture_atlas(texture_atlas const&) = delete;
+  texture_atlas& operator=(texture_atlas const&) = delete;
+
+  // queue a GL_RGBA byte image, returns its surface index, valid after build
+  std::uint32_t add(pixel_data image);
+  // choose the layer size from the largest image, pack and upload all queued images
+  // throws if an image is not GL_RGBA bytes
+  void build();
+
+  surface const& get(std::uint32_t index) const;
+  std::size_t size() const;
+  texture_object const& texture() const;
+  // layer size and count of the built array
+  std::size_t layer_width() const;
+  std::size_t layer_height() const;
+  std::size_t layers() const;
+  // share of the atlas layers covered by images
+  float atlas_occupancy() const;
+
+ private:
+  std::vector<pixel_data> m_images;
+  std::vector<surface> m_surfaces;
+  texture_object m_texture;
+  std::size_t m_layer_width;
+  std::size_t m_layer_height;
+  std::size_t m_layers;
+  float m_atlas_occupancy;
+  // queued images on the cpu, array with its mip levels on the gpu
+  asset_memory::handle m_asset;
+};
+
+#endif
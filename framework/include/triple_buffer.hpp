@@ -0,0 +1,58 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <atomic>
+
+// lock free handoff of values from one producer to one consumer thread
+// the producer always has a free slot to write, the consumer always reads the latest published one,
+// slots are reused so their allocations survive between frames
+template<typename T>
+class triple_buffer {
+ public:
+  triple_buffer()
+   :m_slots{}
+   ,m_write{0}
+   ,m_middle{1}
+   ,m_read{2}
+  {}
+  triple_buffer(triple_buffer const&) = delete;
+  triple_buffer& operator=(triple_buffer const&) = delete;
+
+  // slot owned by the producer until publish, holds an older value
+  T& write_slot() {
+    return m_slots[m_write];
+  }
+  // hand the write slot to the consumer, replaces a published value that was not acquired yet
+  void publish() {
+    unsigned previous = m_middle.exchange(m_write | FRESH, std::memory_order_acq_rel);
+    m_write = previous & INDEX;
+  }
+
+  // make the latest published value readable, false if nothing was published since the last acquire
+  bool acquire() {
+    // only the producer sets the flag, so it can not disappear between load and exchange
+    if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) {
+      return false;
+    }
+    unsigned previous = m_middle.exchange(m_read, std::memory_order_acq_rel);
+    m_read = previous & INDEX;
+    return true;
+  }
+  // slot owned by the consumer until the next acquire
+  T const& read_slot() const {
+    return m_slots[m_read];
+  }
+
+ private:
+  static const unsigned INDEX = 3;
+  // set while the middle slot holds a value the consumer has not seen
+  static const unsigned FRESH = 4;
+
+  T m_slots[3];
+  unsigned m_write;
+  // index of the slot between producer and consumer, with fresh flag
+  std::atomic<unsigned> m_middle;
+  unsigned m_read;
+};
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef VERTEX_LAYOUT_HPP
+#define VERTEX_LAYOUT_HPP
+
+#include "command_buffer.hpp"
+#include "model.hpp"
+#include "structs.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// interleaved vertex layouts described by types, strides and offsets are known at compile time
+// a layout is bound to consecutive attribute locations, matrices take one location per column
+
+// gl enum of an attribute component type
+template<typename T>
+struct gl_component_type;
+template<>
+struct gl_component_type<float> {
+  static constexpr GLenum value = GL_FLOAT;
+};
+template<>
+struct gl_component_type<std::uint8_t> {
+  static constexpr GLenum value = GL_UNSIGNED_BYTE;
+};
+template<>
+struct gl_component_type<std::uint32_t> {
+  static constexpr GLenum value = GL_UNSIGNED_INT;
+};
+
+// components values of type T per location, Flag is the matching model attribute or 0
+template<typename T, std::size_t Components, std::size_t Columns = 1, bool Normalized = false, model::attrib_flag_t Flag = 0>
+struct vertex_attribute {
+  typedef T component_type;
+  static constexpr std::size_t components = Components;
+  static constexpr std::size_t columns = Columns;
+  static constexpr bool normalized = Normalized;
+  static constexpr model::attrib_flag_t flag = Flag;
+  static constexpr std::size_t column_bytes = sizeof(T) * Components;
+  static constexpr std::size_t bytes = column_bytes * Columns;
+};
+
+// attributes stored in models, flags equal the ones of model::VERTEX_ATTRIBS
+typedef vertex_attribute<float, 3, 1, false, 1 << 0> position_attribute;
+typedef vertex_attribute<float, 3, 1, false, 1 << 1> normal_attribute;
+typedef vertex_attribute<float, 2, 1, false, 1 << 2> texcoord_attribute;
+typedef vertex_attribute<float, 3, 1, false, 1 << 3> tangent_attribute;
+typedef vertex_attribute<float, 3, 1, false, 1 << 4> bitangent_attribute;
+// attributes of other vertex and instance data
+typedef vertex_attribute<float, 1> float_attribute;
+typedef vertex_attribute<float, 3> vec3_attribute;
+typedef vertex_attribute<float, 4> vec4_attribute;
+typedef vertex_attribute<float, 4, 4> mat4_attribute;
+// four bytes read as floats in [0, 1]
+typedef vertex_attribute<std::uint8_t, 4, 1, true> color_attribute;
+
+template<typename... Attributes>
+struct vertex_layout;
+
+template<>
+struct vertex_layout<> {
+  static constexpr std::size_t count = 0;
+  static constexpr std::size_t stride = 0;
+  static constexpr std::size_t locations = 0;
+  static constexpr model::attrib_flag_t flags = 0;
+  // flag of the first attribute, larger than all flags if there is none
+  static constexpr model::attrib_flag_t first_flag = 1 << 30;
+  // attributes with flags appear in the order of model::VERTEX_ATTRIBS and no other ones are present
+  static constexpr bool model_order = true;
+};
+
+template<typename First, typename... Rest>
+struct vertex_layout<First, Rest...> {
+  typedef First first;
+  typedef vertex_layout<Rest...> rest;
+  static constexpr std::size_t count = 1 + rest::count;
+  static constexpr std::size_t stride = First::bytes + rest::stride;
+  static constexpr std::size_t locations = First::columns + rest::locations;
+  static constexpr model::attrib_flag_t flags = First::flag | rest::flags;
+  static constexpr model::attrib_flag_t first_flag = First::flag;
+  static constexpr bool model_order = First::flag != 0 && First::flag < rest::first_flag && rest::model_order;
+};
+
+// type, byte offset and location offset of attribute Index in Layout
+template<std::size_t Index, typename Layout>
+struct layout_element;
+
+template<typename First, typename... Rest>
+struct layout_element<0, vertex_layout<First, Rest...>> {
+  typedef First type;
+  static constexpr std::size_t offset = 0;
+  static constexpr std::size_t location = 0;
+};
+
+template<std::size_t Index, typename First, typename... Rest>
+struct layout_element<Index, vertex_layout<First, Rest...>> {
+  typedef layout_element<Index - 1, vertex_layout<Rest...>> next;
+  typedef typename next::type type;
+  static constexpr std::size_t offset = First::bytes + next::offset;
+  static constexpr std::size_t location = First::columns + next::location;
+};
+
+// the interleaved data of a model with the given attributes fits the layout
+template<typename Layout>
+struct is_model_layout {
+  static constexpr bool value = Layout::model_order && Layout::count > 0;
+};
+
+namespace detail {
+  // walks the attributes of a layout with the given stride, Offset and Location are those of the current attribute
+  template<std::size_t Stride, std::size_t Offset, std::size_t Location, typename Layout>
+  struct layout_walker;
+
+  template<std::size_t Stride, std::size_t Offset, std::size_t Location>
+  struct layout_walker<Stride, Offset, Location, vertex_layout<>> {
+    static void enable(GLuint, GLuint) {}
+    static void point(GLuint, std::uintptr_t) {}
+    static void record(command_buffer&, std::uint32_t, std::uint64_t) {}
+  };
+
+  template<std::size_t Stride, std::size_t Offset, std::size_t Location, typename First, typename... Rest>
+  struct layout_walker<Stride, Offset, Location, vertex_layout<First, Rest...>> {
+    typedef layout_walker<Stride, Offset + First::bytes, Location + First::columns, vertex_layout<Rest...>> next;
+
+    static void enable(GLuint first_location, GLuint divisor) {
+      for (GLuint column = 0; column < First::columns; ++column) {
+        glEnableVertexAttribArray(first_location + GLuint(Location) + column);
+        glVertexAttribDivisor(first_location + GLuint(Location) + column, divisor);
+      }
+      next::enable(first_location, divisor);
+    }
+
+    static void point(GLuint first_location, std::uintptr_t base_offset) {
+      for (GLuint column = 0; column < First::columns; ++column) {
+        glVertexAttribPointer(first_location + GLuint(Location) + column, GLint(First::components), gl_component_type<typename First::component_type>::value,
+                              First::normalized ? GL_TRUE : GL_FALSE, GLsizei(Stride),
+                              reinterpret_cast<GLvoid const*>(base_offset + Offset + column * First::column_bytes));
+      }
+      next::point(first_location, base_offset);
+    }
+
+    static void record(command_buffer& commands, std::uint32_t first_location, std::uint64_t base_offset) {
+      static_assert(std::is_same<typename First::component_type, float>::value && !First::normalized,
+                    "recorded attribute pointers only support float components");
+      for (std::uint32_t column = 0; column < First::columns; ++column) {
+        commands.attribute_pointer(first_location + std::uint32_t(Location) + column, std::uint32_t(First::components), std::uint32_t(Stride),
+                                   base_offset + Offset + column * First::column_bytes);
+      }
+      next::record(commands, first_location, base_offset);
+    }
+  };
+
+  template<typename Layout>
+  struct walk : layout_walker<Layout::stride, 0, 0, Layout> {};
+}
+
+// enable the attribute arrays of the layout in the bound vertex array, a divisor of 1 advances them per instance
+template<typename Layout>
+void enable_vertex_attributes(GLuint first_location = 0, GLuint divisor = 0) {
+  detail::walk<Layout>::enable(first_location, divisor);
+}
+
+// point the attributes of the layout at the bound array buffer, base_offset is the byte position of the first vertex
+template<typename Layout>
+void set_vertex_attributes(GLuint first_location = 0, std::uintptr_t base_offset = 0) {
+  detail::walk<Layout>::point(first_location, base_offset);
+}
+
+// record the attribute pointers of the layout, for data whose position changes every frame
+template<typename Layout>
+void record_vertex_attributes(command_buffer& commands, std::uint32_t first_location, std::uint64_t base_offset) {
+  detail::walk<Layout>::record(commands, first_location, base_offset);
+}
+
+// vertex array object with one buffer holding the vertices, the vertex type must have the size of the layout
+// vertices may be null to only allocate the buffer
+template<typename Layout, typename Vertex>
+model_object make_vertex_array(Vertex const* vertices, std::size_t count, GLenum draw_mode, GLenum usage = GL_STATIC_DRAW, GLuint first_location = 0) {
+  static_assert(sizeof(Vertex) == Layout::stride, "vertex type does not match the layout stride");
+  model_object result{};
+  glGenVertexArrays(1, &result.vertex_AO);
+  glBindVertexArray(result.vertex_AO);
+  glGenBuffers(1, &result.vertex_BO);
+  glBindBuffer(GL_ARRAY_BUFFER, result.vertex_BO);
+  glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(Layout::stride * count), vertices, usage);
+  enable_vertex_attributes<Layout>(first_location);
+  set_vertex_attributes<Layout>(first_location);
+  result.draw_mode = draw_mode;
+  result.num_elements = GLsizei(count);
+  return result;
+}
+
+#endif
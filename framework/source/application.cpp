@@ -14,6 +14,8 @@ Application::Application(std::string const& resource_path)
  :m_resource_path{resource_path}
  ,m_view_transform{glm::translate(glm::fmat4{}, glm::fvec3{0.0f, 0.0f, 4.0f})}
  ,m_view_projection{1.0}
+ ,m_projection_set{false}
+ ,m_frame_alpha{0.0f}
  ,m_shaders{}
 {}
 
@@ -26,9 +28,14 @@ Application::~Application() {
 
 void Application::setProjection(glm::fmat4 const& projection_mat) {
   m_view_projection = projection_mat;
+  m_projection_set = true;
   updateProjection();
 }
 
+void Application::setFrameInterpolation(float alpha) {
+  m_frame_alpha = alpha;
+}
+
 // update shader uniform locations
 void Application::updateUniformLocations() {
   for (auto& pair : m_shaders) {
@@ -36,6 +43,8 @@ void Application::updateUniformLocations() {
       // store uniform location in map
       uniform.second = utils::glGetUniformLocation(pair.second.handle, uniform.first.c_str());
     }
+    // new locations or a relinked program, shadowed values must be uploaded again
+    pair.second.invalidate_uniforms();
   }
 }
 
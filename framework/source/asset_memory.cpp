@@ -0,0 +1,135 @@
+#include "asset_memory.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+asset_memory::asset_memory()
+ :m_mutex{}
+ ,m_entries{}
+ ,m_next{0}
+ ,m_policy{KEEP_CPU_COPIES}
+{}
+
+asset_memory& asset_memory::instance() {
+  static asset_memory registry{};
+  return registry;
+}
+
+asset_memory::handle asset_memory::track(std::string const& name, std::string const& category, std::size_t cpu_bytes, std::size_t gpu_bytes) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  handle asset = m_next++;
+  m_entries[asset] = entry{name, category, cpu_bytes, gpu_bytes, false};
+  return asset;
+}
+
+void asset_memory::set_cpu_bytes(handle asset, std::size_t bytes) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  auto found = m_entries.find(asset);
+  if (found != m_entries.end()) {
+    found->second.cpu_bytes = bytes;
+  }
+}
+
+void asset_memory::set_gpu_bytes(handle asset, std::size_t bytes) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  auto found = m_entries.find(asset);
+  if (found != m_entries.end()) {
+    found->second.gpu_bytes = bytes;
+  }
+}
+
+void asset_memory::evicted(handle asset) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  auto found = m_entries.find(asset);
+  if (found != m_entries.end()) {
+    found->second.cpu_bytes = 0;
+    found->second.evicted = true;
+  }
+}
+
+void asset_memory::untrack(handle asset) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  m_entries.erase(asset);
+}
+
+void asset_memory::set_policy(policy residency) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  m_policy = residency;
+}
+
+asset_memory::policy asset_memory::get_policy() const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_policy;
+}
+
+bool asset_memory::evict_after_upload(bool needed_on_cpu) const {
+  return !needed_on_cpu && get_policy() == EVICT_CPU_COPIES;
+}
+
+std::vector<asset_memory::entry> asset_memory::entries() const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  std::vector<entry> result{};
+  result.reserve(m_entries.size());
+  for (auto const& pair : m_entries) {
+    result.push_back(pair.second);
+  }
+  return result;
+}
+
+std::size_t asset_memory::cpu_bytes() const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  std::size_t total = 0;
+  for (auto const& pair : m_entries) {
+    total += pair.second.cpu_bytes;
+  }
+  return total;
+}
+
+std::size_t asset_memory::gpu_bytes() const {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  std::size_t total = 0;
+  for (auto const& pair : m_entries) {
+    total += pair.second.gpu_bytes;
+  }
+  return total;
+}
+
+void asset_memory::write(benchmark::json_writer& json) const {
+  std::vector<entry> assets = entries();
+  json.begin_object();
+  json.key("policy").value(get_policy() == EVICT_CPU_COPIES ? "evict_cpu_copies" : "keep_cpu_copies");
+  json.key("cpu_bytes").value(cpu_bytes());
+  json.key("gpu_bytes").value(gpu_bytes());
+  json.key("assets").begin_array();
+  for (entry const& asset : assets) {
+    json.begin_object();
+    json.key("name").value(asset.name);
+    json.key("category").value(asset.category);
+    json.key("cpu_bytes").value(asset.cpu_bytes);
+    json.key("gpu_bytes").value(asset.gpu_bytes);
+    json.key("evicted").value(asset.evicted);
+    json.end_object();
+  }
+  json.end_array();
+  json.end_object();
+}
+
+void asset_memory::print(std::ostream& stream) const {
+  std::vector<entry> assets = entries();
+  std::sort(assets.begin(), assets.end(), [](entry const& a, entry const& b) {
+    return a.cpu_bytes + a.gpu_bytes > b.cpu_bytes + b.gpu_bytes;
+  });
+  const double kilobyte = 1024.0;
+  // formatted separately, so the caller stream keeps its flags and precision
+  std::ostringstream out{};
+  out << std::fixed << std::setprecision(1);
+  out << "Asset memory, cpu " << double(cpu_bytes()) / kilobyte << " KiB, gpu " << double(gpu_bytes()) / kilobyte << " KiB" << std::endl;
+  for (entry const& asset : assets) {
+    out << "  " << std::left << std::setw(10) << asset.category << std::setw(24) << asset.name << std::right
+        << " cpu " << std::setw(10) << double(asset.cpu_bytes) / kilobyte << " KiB"
+        << " gpu " << std::setw(10) << double(asset.gpu_bytes) / kilobyte << " KiB"
+        << (asset.evicted ? " evicted" : "") << std::endl;
+  }
+  stream << out.str() << std::flush;
+}
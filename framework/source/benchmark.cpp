@@ -0,0 +1,252 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+namespace benchmark {
+
+std::vector<input_event> read_input_timeline(std::string const& file_path) {
+  std::ifstream file_in{file_path};
+  if (!file_in) {
+    std::cerr << "File \'" << file_path << "\' not found" << std::endl;
+    throw std::invalid_argument(file_path);
+  }
+
+  std::vector<input_event> events{};
+  std::string line{};
+  while (std::getline(file_in, line)) {
+    // skip comments and empty lines
+    std::size_t first = line.find_first_not_of(" \t");
+    if (first == std::string::npos || line[first] == '#') {
+      continue;
+    }
+    std::istringstream line_stream{line};
+    input_event event{0, 0, 0, 0};
+    if (!(line_stream >> event.frame >> event.key >> event.action)) {
+      throw std::logic_error("Malformed input event in " + file_path + ": " + line);
+    }
+    // modifiers are optional
+    line_stream >> event.mods;
+    events.push_back(event);
+  }
+  // events must be dispatched in frame order
+  std::stable_sort(events.begin(), events.end(), [](input_event const& a, input_event const& b) {
+    return a.frame < b.frame;
+  });
+  return events;
+}
+
+void write_input_timeline(std::string const& file_path, std::vector<input_event> const& events) {
+  std::ofstream file_out{file_path};
+  if (!file_out) {
+    throw std::invalid_argument(file_path);
+  }
+  file_out << "# frame key action mods" << std::endl;
+  for (auto const& event : events) {
+    file_out << event.frame << " " << event.key << " " << event.action << " " << event.mods << std::endl;
+  }
+}
+
+double percentile(std::vector<double> values, double fraction) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::size_t rank = std::size_t(std::ceil(fraction * double(values.size())));
+  rank = std::min(std::max(rank, std::size_t(1)), values.size()) - 1;
+  std::nth_element(values.begin(), values.begin() + rank, values.end());
+  return values[rank];
+}
+
+double now() {
+  auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration<double>(since_epoch).count();
+}
+
+double thread_cpu_time() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  timespec time{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return double(time.tv_sec) + double(time.tv_nsec) * 1e-9;
+#else
+  return now();
+#endif
+}
+
+std::size_t peak_rss() {
+#if defined(__unix__) || defined(__APPLE__)
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  #ifdef __APPLE__
+    // reported in bytes
+    return std::size_t(usage.ru_maxrss);
+  #else
+    // reported in kilobytes
+    return std::size_t(usage.ru_maxrss) * 1024;
+  #endif
+#else
+  return 0;
+#endif
+}
+
+///////////////////////////// json writer ////////////////////////////////
+json_writer::json_writer(std::ostream& stream)
+ :m_stream(stream)
+ ,m_has_element{false}
+ ,m_after_key{false}
+{}
+
+void json_writer::separate() {
+  if (m_after_key) {
+    m_after_key = false;
+    return;
+  }
+  if (m_has_element.back()) {
+    m_stream << ",";
+  }
+  m_has_element.back() = true;
+}
+
+void json_writer::begin_object() {
+  separate();
+  m_stream << "{";
+  m_has_element.push_back(false);
+}
+
+void json_writer::end_object() {
+  m_has_element.pop_back();
+  m_stream << "}";
+  // top level object is complete
+  if (m_has_element.size() == 1) {
+    m_stream << std::endl;
+  }
+}
+
+void json_writer::begin_array() {
+  separate();
+  m_stream << "[";
+  m_has_element.push_back(false);
+}
+
+void json_writer::end_array() {
+  m_has_element.pop_back();
+  m_stream << "]";
+}
+
+json_writer& json_writer::key(std::string const& name) {
+  separate();
+  m_stream << "\"" << name << "\":";
+  m_after_key = true;
+  return *this;
+}
+
+void json_writer::value(double number) {
+  separate();
+  // json has no representation for inf and nan
+  if (std::isfinite(number)) {
+    m_stream << number;
+  }
+  else {
+    m_stream << "null";
+  }
+}
+
+void json_writer::value(bool boolean) {
+  separate();
+  m_stream << (boolean ? "true" : "false");
+}
+
+void json_writer::value(std::string const& text) {
+  separate();
+  m_stream << "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      m_stream << '\\';
+    }
+    m_stream << c;
+  }
+  m_stream << "\"";
+}
+
+void json_writer::value(char const* text) {
+  value(std::string{text});
+}
+
+///////////////////////////// frame report ////////////////////////////////
+// write average and percentiles of values in milliseconds
+static void write_statistics(json_writer& json, std::vector<double> const& seconds) {
+  double total = 0.0;
+  for (double value : seconds) {
+    total += value;
+  }
+  json.begin_object();
+  json.key("average").value(total / double(seconds.size()) * 1000.0);
+  json.key("p50").value(percentile(seconds, 0.50) * 1000.0);
+  json.key("p95").value(percentile(seconds, 0.95) * 1000.0);
+  json.key("p99").value(percentile(seconds, 0.99) * 1000.0);
+  json.key("min").value(*std::min_element(seconds.begin(), seconds.end()) * 1000.0);
+  json.key("max").value(*std::max_element(seconds.begin(), seconds.end()) * 1000.0);
+  json.end_object();
+}
+
+void write_frame_report(json_writer& json, std::vector<frame_sample> const& frames) {
+  if (frames.empty()) {
+    json.begin_object();
+    json.key("frames").value(0u);
+    json.end_object();
+    return;
+  }
+
+  std::vector<double> totals{}, polls{}, updates{}, renders{}, presents{};
+  std::vector<unsigned> draw_calls{};
+  for (auto const& frame : frames) {
+    totals.push_back(frame.total);
+    polls.push_back(frame.poll);
+    updates.push_back(frame.update);
+    renders.push_back(frame.render);
+    presents.push_back(frame.present);
+    draw_calls.push_back(frame.draw_calls);
+  }
+  double draw_call_sum = 0.0;
+  for (unsigned count : draw_calls) {
+    draw_call_sum += double(count);
+  }
+
+  json.begin_object();
+  json.key("frames").value(frames.size());
+  json.key("frame_ms");
+  write_statistics(json, totals);
+  // cpu time of the thread running the phase, waiting for the gpu or vsync and work of job threads is not included
+  json.key("phase_cpu_ms").begin_object();
+  json.key("poll");
+  write_statistics(json, polls);
+  json.key("update");
+  write_statistics(json, updates);
+  json.key("render");
+  write_statistics(json, renders);
+  json.key("present");
+  write_statistics(json, presents);
+  json.end_object();
+  json.key("draw_calls").begin_object();
+  json.key("average").value(draw_call_sum / double(frames.size()));
+  json.key("min").value(*std::min_element(draw_calls.begin(), draw_calls.end()));
+  json.key("max").value(*std::max_element(draw_calls.begin(), draw_calls.end()));
+  json.end_object();
+  json.key("frame_times_ms").begin_array();
+  for (double total : totals) {
+    json.value(total * 1000.0);
+  }
+  json.end_array();
+  json.end_object();
+}
+
+}
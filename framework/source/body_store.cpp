@@ -0,0 +1,55 @@
+#include "body_store.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+std::size_t body_store::add(scene_graph& scene, int parent, orbit const& motion, float scale, std::uint32_t mesh, std::uint8_t body_flags, std::uint32_t surface) {
+  std::size_t body = size();
+  int parent_node = scene_graph::NO_PARENT;
+  if (parent >= 0) {
+    parent_node = int(orbit_nodes[std::size_t(parent)]);
+  }
+  // satellites attach to the orbit node, so they are not scaled with their parent
+  std::size_t orbit_node = scene.add_node(parent_node);
+  std::size_t mesh_node = scene.add_node(int(orbit_node), glm::scale(glm::fmat4{}, glm::fvec3{scale}));
+
+  orbits.push_back(motion);
+  scales.push_back(scale);
+  flags.push_back(body_flags);
+  positions.push_back(glm::fvec3{0.0f});
+  orbit_nodes.push_back(orbit_node);
+  mesh_nodes.push_back(mesh_node);
+  meshes.push_back(mesh);
+  surfaces.push_back(surface);
+  return body;
+}
+
+std::size_t body_store::size() const {
+  return orbits.size();
+}
+
+void update_orbits(body_store const& bodies, float time, scene_graph& scene) {
+  for (std::size_t i = 0; i < bodies.size(); ++i) {
+    if (bodies.flags[i] & BODY_STATIC) {
+      continue;
+    }
+    orbit const& motion = bodies.orbits[i];
+    float angle = time * motion.angular_speed + motion.phase;
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    // rotation around y followed by translation along the rotated x-axis, written out
+    // to avoid building and multiplying two matrices per body
+    glm::fmat4 local{ c,   0.0f, -s,   0.0f,
+                      0.0f, 1.0f, 0.0f, 0.0f,
+                      s,   0.0f, c,    0.0f,
+                      c * motion.radius, 0.0f, -s * motion.radius, 1.0f};
+    scene.set_local(bodies.orbit_nodes[i], local);
+  }
+}
+
+void gather_positions(body_store& bodies, scene_graph const& scene) {
+  for (std::size_t i = 0; i < bodies.size(); ++i) {
+    bodies.positions[i] = glm::fvec3{scene.world(bodies.mesh_nodes[i])[3]};
+  }
+}
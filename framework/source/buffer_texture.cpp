@@ -0,0 +1,60 @@
+#include "buffer_texture.hpp"
+
+#include <algorithm>
+
+// storage allocated before the first update, an empty buffer can not back a texture
+const std::size_t MIN_CAPACITY = 256;
+
+buffer_texture::buffer_texture(GLenum format, std::string const& name)
+ :m_format{format}
+ ,m_buffer{0}
+ ,m_texture{0}
+ ,m_capacity{MIN_CAPACITY}
+ ,m_size{0}
+ ,m_asset{0}
+{
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+  glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(m_capacity), nullptr, GL_STREAM_DRAW);
+  // the texture refers to the buffer object, so it stays attached when the storage is reallocated
+  glGenTextures(1, &m_texture);
+  glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, m_format, m_buffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  m_asset = asset_memory::instance().track(name, "buffer", 0, m_capacity);
+}
+
+buffer_texture::~buffer_texture() {
+  asset_memory::instance().untrack(m_asset);
+  glDeleteTextures(1, &m_texture);
+  glDeleteBuffers(1, &m_buffer);
+}
+
+void buffer_texture::update(void const* data, std::size_t bytes) {
+  glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+  if (bytes > m_capacity) {
+    // grow by half at least, so slowly rising sizes do not reallocate every frame
+    m_capacity = std::max(bytes, m_capacity + m_capacity / 2);
+    asset_memory::instance().set_gpu_bytes(m_asset, m_capacity);
+  }
+  // orphan the storage, the driver hands out fresh memory while the old one is still read
+  glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(m_capacity), nullptr, GL_STREAM_DRAW);
+  if (bytes > 0) {
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, GLsizeiptr(bytes), data);
+  }
+  m_size = bytes;
+}
+
+void buffer_texture::bind(GLuint unit) const {
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+  glActiveTexture(GL_TEXTURE0);
+}
+
+GLuint buffer_texture::texture() const {
+  return m_texture;
+}
+
+std::size_t buffer_texture::size() const {
+  return m_size;
+}
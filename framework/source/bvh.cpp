@@ -0,0 +1,313 @@
+#include "bvh.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+
+// median splits halve the primitives, so trees over 32 bit indices are at most 33 levels deep
+// and a depth first traversal holds at most one pending sibling per level
+const std::size_t MAX_STACK_SIZE = 64;
+
+// result of testing a box against a frustum
+enum containment {
+  OUTSIDE,
+  INTERSECTING,
+  INSIDE
+};
+
+static containment classify(frustum const& volume, aabb const& box) {
+  containment result = INSIDE;
+  for (auto const& plane : volume.planes) {
+    glm::fvec3 normal{plane};
+    // corners furthest along and against the plane normal
+    glm::fvec3 positive{plane.x >= 0.0f ? box.max.x : box.min.x,
+                        plane.y >= 0.0f ? box.max.y : box.min.y,
+                        plane.z >= 0.0f ? box.max.z : box.min.z};
+    glm::fvec3 negative{plane.x >= 0.0f ? box.min.x : box.max.x,
+                        plane.y >= 0.0f ? box.min.y : box.max.y,
+                        plane.z >= 0.0f ? box.min.z : box.max.z};
+    if (glm::dot(normal, positive) + plane.w < 0.0f) {
+      return OUTSIDE;
+    }
+    if (glm::dot(normal, negative) + plane.w < 0.0f) {
+      result = INTERSECTING;
+    }
+  }
+  return result;
+}
+
+// squared distance from point to box, zero inside
+static float distance_squared(aabb const& box, glm::fvec3 const& point) {
+  glm::fvec3 offset = glm::max(glm::max(box.min - point, point - box.max), glm::fvec3{0.0f});
+  return glm::dot(offset, offset);
+}
+
+// ray parameter of entry into box, negative if missed
+static float intersect_ray(aabb const& box, glm::fvec3 const& origin, glm::fvec3 const& inverse_direction, float max_distance) {
+  glm::fvec3 t0 = (box.min - origin) * inverse_direction;
+  glm::fvec3 t1 = (box.max - origin) * inverse_direction;
+  glm::fvec3 t_near = glm::min(t0, t1);
+  glm::fvec3 t_far = glm::max(t0, t1);
+  float enter = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+  float exit = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, max_distance));
+  return enter <= exit ? enter : -1.0f;
+}
+
+static aabb merge(aabb const& a, aabb const& b) {
+  return aabb{glm::min(a.min, b.min), glm::max(a.max, b.max)};
+}
+
+bvh::bvh()
+ :m_nodes{}
+ ,m_primitives{}
+ ,m_boxes{}
+ ,m_ordered_boxes{}
+ ,m_leaf_size{4}
+{}
+
+void bvh::build(std::vector<aabb> const& boxes, std::size_t leaf_size) {
+  m_boxes = boxes;
+  m_leaf_size = std::max(leaf_size, std::size_t(1));
+  m_primitives.resize(boxes.size());
+  for (std::uint32_t i = 0; i < m_primitives.size(); ++i) {
+    m_primitives[i] = i;
+  }
+  m_nodes.clear();
+  m_ordered_boxes.resize(0);
+  if (boxes.empty()) {
+    return;
+  }
+  // binary tree with at least one primitive per leaf has at most 2n - 1 nodes
+  m_nodes.reserve(2 * boxes.size() - 1);
+  m_nodes.push_back(node{});
+  build_node(0, 0, std::uint32_t(boxes.size()));
+  m_ordered_boxes.resize(boxes.size());
+  for (std::size_t p = 0; p < m_primitives.size(); ++p) {
+    m_ordered_boxes.set(p, m_boxes[m_primitives[p]].min, m_boxes[m_primitives[p]].max);
+  }
+}
+
+void bvh::build_node(std::uint32_t node_index, std::uint32_t first, std::uint32_t count) {
+  aabb bounds = m_boxes[m_primitives[first]];
+  aabb centroid_bounds{(bounds.min + bounds.max) * 0.5f, (bounds.min + bounds.max) * 0.5f};
+  for (std::uint32_t i = first; i < first + count; ++i) {
+    aabb const& box = m_boxes[m_primitives[i]];
+    bounds = merge(bounds, box);
+    glm::fvec3 centroid = (box.min + box.max) * 0.5f;
+    centroid_bounds = aabb{glm::min(centroid_bounds.min, centroid), glm::max(centroid_bounds.max, centroid)};
+  }
+  m_nodes[node_index].bounds = bounds;
+  m_nodes[node_index].children = 0;
+  m_nodes[node_index].first = first;
+  m_nodes[node_index].count = count;
+
+  glm::fvec3 extent = centroid_bounds.max - centroid_bounds.min;
+  // stop at leaf size or when all centroids coincide
+  if (count <= m_leaf_size || glm::max(extent.x, glm::max(extent.y, extent.z)) <= 0.0f) {
+    return;
+  }
+  // median split along longest axis of the centroids
+  int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+  std::uint32_t half = count / 2;
+  auto begin = m_primitives.begin() + first;
+  std::nth_element(begin, begin + half, begin + count, [&](std::uint32_t a, std::uint32_t b) {
+    return m_boxes[a].min[axis] + m_boxes[a].max[axis] < m_boxes[b].min[axis] + m_boxes[b].max[axis];
+  });
+
+  // children are stored next to each other
+  std::uint32_t left = std::uint32_t(m_nodes.size());
+  m_nodes.push_back(node{});
+  m_nodes.push_back(node{});
+  m_nodes[node_index].children = left;
+  build_node(left, first, half);
+  build_node(left + 1, first + half, count - half);
+}
+
+void bvh::refit(std::vector<aabb> const& boxes) {
+  m_boxes = boxes;
+  for (std::size_t p = 0; p < m_primitives.size(); ++p) {
+    m_ordered_boxes.set(p, m_boxes[m_primitives[p]].min, m_boxes[m_primitives[p]].max);
+  }
+  // children are always stored after their parent
+  for (std::size_t i = m_nodes.size(); i-- > 0;) {
+    node& current = m_nodes[i];
+    if (current.children == 0) {
+      aabb bounds = m_boxes[m_primitives[current.first]];
+      for (std::uint32_t p = current.first + 1; p < current.first + current.count; ++p) {
+        bounds = merge(bounds, m_boxes[m_primitives[p]]);
+      }
+      current.bounds = bounds;
+    }
+    else {
+      current.bounds = merge(m_nodes[current.children].bounds, m_nodes[current.children + 1].bounds);
+    }
+  }
+}
+
+void bvh::query_frustum(frustum const& volume, std::vector<std::uint32_t>& result) const {
+  if (m_nodes.empty()) {
+    return;
+  }
+  std::uint32_t stack[MAX_STACK_SIZE];
+  std::size_t stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    node const& current = m_nodes[stack[--stack_size]];
+    containment test = classify(volume, current.bounds);
+    if (test == OUTSIDE) {
+      continue;
+    }
+    // a single primitive has the bounds of its leaf
+    if (test == INSIDE || current.count == 1) {
+      result.insert(result.end(), m_primitives.begin() + current.first, m_primitives.begin() + current.first + current.count);
+    }
+    else if (current.children == 0) {
+      std::size_t start = result.size();
+      cull_boxes(volume, m_ordered_boxes, current.first, current.first + current.count, result);
+      // positions in primitive order to primitive indices
+      for (std::size_t r = start; r < result.size(); ++r) {
+        result[r] = m_primitives[result[r]];
+      }
+    }
+    else {
+      stack[stack_size++] = current.children;
+      stack[stack_size++] = current.children + 1;
+    }
+  }
+}
+
+void bvh::query_frustum(frustum const& volume, std::vector<range>& result) const {
+  if (m_nodes.empty()) {
+    return;
+  }
+  std::uint32_t stack[MAX_STACK_SIZE];
+  std::size_t stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    node const& current = m_nodes[stack[--stack_size]];
+    containment test = classify(volume, current.bounds);
+    if (test == OUTSIDE) {
+      continue;
+    }
+    if (current.children == 0 || test == INSIDE) {
+      // merge with previous range if adjacent
+      if (!result.empty() && result.back().first + result.back().count == current.first) {
+        result.back().count += current.count;
+      }
+      else {
+        result.push_back(range{current.first, current.count});
+      }
+    }
+    else {
+      // visit left child first so ranges come out in ascending order
+      stack[stack_size++] = current.children + 1;
+      stack[stack_size++] = current.children;
+    }
+  }
+}
+
+void bvh::query_sphere(glm::fvec3 const& center, float radius, std::vector<std::uint32_t>& result) const {
+  if (m_nodes.empty()) {
+    return;
+  }
+  float radius_squared = radius * radius;
+  std::uint32_t stack[MAX_STACK_SIZE];
+  std::size_t stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    node const& current = m_nodes[stack[--stack_size]];
+    if (distance_squared(current.bounds, center) > radius_squared) {
+      continue;
+    }
+    if (current.children == 0) {
+      for (std::uint32_t p = current.first; p < current.first + current.count; ++p) {
+        if (distance_squared(m_boxes[m_primitives[p]], center) <= radius_squared) {
+          result.push_back(m_primitives[p]);
+        }
+      }
+    }
+    else {
+      stack[stack_size++] = current.children;
+      stack[stack_size++] = current.children + 1;
+    }
+  }
+}
+
+int bvh::nearest(glm::fvec3 const& point, float max_distance) const {
+  int best = -1;
+  float best_squared = max_distance * max_distance;
+  if (m_nodes.empty()) {
+    return best;
+  }
+  std::uint32_t stack[MAX_STACK_SIZE];
+  std::size_t stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    node const& current = m_nodes[stack[--stack_size]];
+    // prune subtrees that cannot contain a closer primitive
+    if (distance_squared(current.bounds, point) >= best_squared) {
+      continue;
+    }
+    if (current.children == 0) {
+      for (std::uint32_t p = current.first; p < current.first + current.count; ++p) {
+        float squared = distance_squared(m_boxes[m_primitives[p]], point);
+        if (squared < best_squared) {
+          best_squared = squared;
+          best = int(m_primitives[p]);
+        }
+      }
+    }
+    else {
+      // descend into closer child first for earlier pruning
+      std::uint32_t near_child = current.children;
+      std::uint32_t far_child = current.children + 1;
+      if (distance_squared(m_nodes[far_child].bounds, point) < distance_squared(m_nodes[near_child].bounds, point)) {
+        std::swap(near_child, far_child);
+      }
+      stack[stack_size++] = far_child;
+      stack[stack_size++] = near_child;
+    }
+  }
+  return best;
+}
+
+int bvh::raycast(glm::fvec3 const& origin, glm::fvec3 const& direction, float& distance) const {
+  int hit = -1;
+  float closest = 1e30f;
+  if (m_nodes.empty()) {
+    return hit;
+  }
+  glm::fvec3 inverse_direction = 1.0f / direction;
+  std::uint32_t stack[MAX_STACK_SIZE];
+  std::size_t stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    node const& current = m_nodes[stack[--stack_size]];
+    if (intersect_ray(current.bounds, origin, inverse_direction, closest) < 0.0f) {
+      continue;
+    }
+    if (current.children == 0) {
+      for (std::uint32_t p = current.first; p < current.first + current.count; ++p) {
+        float t = intersect_ray(m_boxes[m_primitives[p]], origin, inverse_direction, closest);
+        if (t >= 0.0f && t < closest) {
+          closest = t;
+          hit = int(m_primitives[p]);
+        }
+      }
+    }
+    else {
+      stack[stack_size++] = current.children;
+      stack[stack_size++] = current.children + 1;
+    }
+  }
+  distance = closest;
+  return hit;
+}
+
+std::vector<std::uint32_t> const& bvh::primitive_order() const {
+  return m_primitives;
+}
+
+std::size_t bvh::node_count() const {
+  return m_nodes.size();
+}
@@ -0,0 +1,148 @@
+#include "command_buffer.hpp"
+
+// payloads are padded to this, so every header starts aligned
+const std::size_t COMMAND_ALIGNMENT = alignof(command::header);
+
+static std::size_t padded_size(std::size_t size) {
+  return (size + COMMAND_ALIGNMENT - 1) / COMMAND_ALIGNMENT * COMMAND_ALIGNMENT;
+}
+
+command_buffer::command_buffer()
+ :m_data{}
+ ,m_count{0}
+{}
+
+unsigned char* command_buffer::push(command::type kind, std::size_t size) {
+  std::size_t start = m_data.size();
+  m_data.resize(start + sizeof(command::header) + padded_size(size));
+  command::header head{kind, std::uint32_t(size)};
+  unsigned char const* head_bytes = reinterpret_cast<unsigned char const*>(&head);
+  std::copy(head_bytes, head_bytes + sizeof(head), m_data.data() + start);
+  ++m_count;
+  return m_data.data() + start + sizeof(command::header);
+}
+
+void command_buffer::use_program(std::uint32_t program) {
+  push(command::USE_PROGRAM, command::use_program{program});
+}
+
+void command_buffer::bind_vertex_array(std::uint32_t vertex_array) {
+  push(command::BIND_VERTEX_ARRAY, command::bind_vertex_array{vertex_array});
+}
+
+void command_buffer::bind_buffer(command::buffer_target target, std::uint32_t buffer) {
+  push(command::BIND_BUFFER, command::bind_buffer{target, buffer});
+}
+
+void command_buffer::uniform(std::int32_t location, glm::fmat4 const& value) {
+  push(command::UNIFORM_MATRIX, command::uniform_matrix{location, value});
+}
+
+void command_buffer::uniform(std::int32_t location, glm::fvec4 const& value) {
+  push(command::UNIFORM_VECTOR, command::uniform_vector{location, value});
+}
+
+void command_buffer::attribute_pointer(std::uint32_t location, std::uint32_t components, std::uint32_t stride, std::uint64_t offset) {
+  push(command::ATTRIBUTE_POINTER, command::attribute_pointer{location, components, stride, offset});
+}
+
+void command_buffer::attribute_constant(std::uint32_t location, glm::fvec4 const& value) {
+  push(command::ATTRIBUTE_CONSTANT, command::attribute_constant{location, value});
+}
+
+void command_buffer::draw_arrays(command::primitive mode, std::int32_t first, std::int32_t count) {
+  push(command::DRAW_ARRAYS, command::draw_arrays{mode, first, count});
+}
+
+void command_buffer::multi_draw_arrays(command::primitive mode, std::int32_t const* firsts, std::int32_t const* counts, std::uint32_t range_count) {
+  std::size_t ranges_size = sizeof(std::int32_t) * range_count;
+  command::multi_draw_arrays head{mode, range_count};
+  unsigned char* payload = push(command::MULTI_DRAW_ARRAYS, sizeof(head) + ranges_size * 2);
+  unsigned char const* head_bytes = reinterpret_cast<unsigned char const*>(&head);
+  payload = std::copy(head_bytes, head_bytes + sizeof(head), payload);
+  payload = std::copy(reinterpret_cast<unsigned char const*>(firsts), reinterpret_cast<unsigned char const*>(firsts) + ranges_size, payload);
+  std::copy(reinterpret_cast<unsigned char const*>(counts), reinterpret_cast<unsigned char const*>(counts) + ranges_size, payload);
+}
+
+void command_buffer::draw_indexed(command::primitive mode, std::int32_t index_count, std::uint64_t first_index, std::int32_t base_vertex, std::int32_t instances) {
+  push(command::DRAW_INDEXED, command::draw_indexed{mode, index_count, first_index, base_vertex, instances});
+}
+
+void command_buffer::clear() {
+  m_data.clear();
+  m_count = 0;
+}
+
+bool command_buffer::empty() const {
+  return m_count == 0;
+}
+
+std::size_t command_buffer::command_count() const {
+  return m_count;
+}
+
+std::vector<unsigned char> const& command_buffer::data() const {
+  return m_data;
+}
+
+command_reader::command_reader(command_buffer const& commands)
+ :m_position{nullptr}
+ ,m_next{commands.data().data()}
+ ,m_end{commands.data().data() + commands.data().size()}
+ ,m_header{}
+{}
+
+bool command_reader::next() {
+  if (m_next >= m_end) {
+    return false;
+  }
+  m_position = m_next;
+  std::copy(m_position, m_position + sizeof(command::header), reinterpret_cast<unsigned char*>(&m_header));
+  m_next = m_position + sizeof(command::header) + padded_size(m_header.size);
+  return true;
+}
+
+command::type command_reader::kind() const {
+  return m_header.kind;
+}
+
+unsigned char const* command_reader::trailing(std::size_t payload_size) const {
+  return m_position + sizeof(command::header) + payload_size;
+}
+
+command_stream::command_stream()
+ :m_buffers{}
+ ,m_size{0}
+{}
+
+command_buffer& command_stream::append() {
+  return m_buffers[append(1)];
+}
+
+std::size_t command_stream::append(std::size_t count) {
+  std::size_t first = m_size;
+  m_size += count;
+  if (m_buffers.size() < m_size) {
+    m_buffers.resize(m_size);
+  }
+  return first;
+}
+
+command_buffer& command_stream::buffer(std::size_t index) {
+  return m_buffers[index];
+}
+
+command_buffer const& command_stream::buffer(std::size_t index) const {
+  return m_buffers[index];
+}
+
+std::size_t command_stream::size() const {
+  return m_size;
+}
+
+void command_stream::clear() {
+  for (std::size_t i = 0; i < m_size; ++i) {
+    m_buffers[i].clear();
+  }
+  m_size = 0;
+}
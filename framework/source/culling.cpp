@@ -0,0 +1,108 @@
+#include "culling.hpp"
+
+#include <glm/geometric.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+  #define CULLING_SSE
+  #include <xmmintrin.h>
+#endif
+
+void bounding_boxes::resize(std::size_t count) {
+  min_x.resize(count);
+  min_y.resize(count);
+  min_z.resize(count);
+  max_x.resize(count);
+  max_y.resize(count);
+  max_z.resize(count);
+}
+
+void bounding_boxes::set(std::size_t index, glm::fvec3 const& box_min, glm::fvec3 const& box_max) {
+  min_x[index] = box_min.x;
+  min_y[index] = box_min.y;
+  min_z[index] = box_min.z;
+  max_x[index] = box_max.x;
+  max_y[index] = box_max.y;
+  max_z[index] = box_max.z;
+}
+
+std::size_t bounding_boxes::size() const {
+  return min_x.size();
+}
+
+frustum extract_frustum(glm::fmat4 const& view_projection) {
+  // rows of the matrix, glm is column major
+  glm::fvec4 row[4];
+  for (int i = 0; i < 4; ++i) {
+    row[i] = glm::fvec4{view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]};
+  }
+
+  frustum volume{};
+  volume.planes[0] = row[3] + row[0];
+  volume.planes[1] = row[3] - row[0];
+  volume.planes[2] = row[3] + row[1];
+  volume.planes[3] = row[3] - row[1];
+  volume.planes[4] = row[3] + row[2];
+  volume.planes[5] = row[3] - row[2];
+  // normalize so plane distances are euclidean
+  for (auto& plane : volume.planes) {
+    plane /= glm::length(glm::fvec3{plane});
+  }
+  return volume;
+}
+
+std::size_t cull_boxes(frustum const& volume, bounding_boxes const& boxes, std::size_t first, std::size_t last,
+                       std::vector<std::uint32_t>& visible) {
+  std::size_t start = visible.size();
+  visible.resize(start + (last - first));
+  std::uint32_t* out = visible.data() + start;
+  std::size_t num_visible = 0;
+  std::size_t i = first;
+
+#ifdef CULLING_SSE
+  // broadcast plane components once, the corner furthest along the normal is picked per plane
+  __m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+  for (int p = 0; p < 6; ++p) {
+    plane_x[p] = _mm_set1_ps(volume.planes[p].x);
+    plane_y[p] = _mm_set1_ps(volume.planes[p].y);
+    plane_z[p] = _mm_set1_ps(volume.planes[p].z);
+    plane_w[p] = _mm_set1_ps(volume.planes[p].w);
+  }
+  __m128 const zero = _mm_setzero_ps();
+
+  for (; i + 4 <= last; i += 4) {
+    __m128 const corner_x[2] = {_mm_loadu_ps(&boxes.min_x[i]), _mm_loadu_ps(&boxes.max_x[i])};
+    __m128 const corner_y[2] = {_mm_loadu_ps(&boxes.min_y[i]), _mm_loadu_ps(&boxes.max_y[i])};
+    __m128 const corner_z[2] = {_mm_loadu_ps(&boxes.min_z[i]), _mm_loadu_ps(&boxes.max_z[i])};
+    // lanes stay set while the box is inside all planes so far
+    __m128 inside = _mm_cmpeq_ps(zero, zero);
+    for (int p = 0; p < 6; ++p) {
+      glm::fvec4 const& plane = volume.planes[p];
+      __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(corner_x[plane.x >= 0.0f], plane_x[p]), _mm_mul_ps(corner_y[plane.y >= 0.0f], plane_y[p])),
+                                   _mm_add_ps(_mm_mul_ps(corner_z[plane.z >= 0.0f], plane_z[p]), plane_w[p]));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+    }
+    // compact visible lanes
+    int mask = _mm_movemask_ps(inside);
+    for (std::uint32_t lane = 0; lane < 4; ++lane) {
+      out[num_visible] = std::uint32_t(i) + lane;
+      num_visible += (mask >> lane) & 1;
+    }
+  }
+#endif
+
+  // remainder and scalar fallback
+  for (; i < last; ++i) {
+    bool inside = true;
+    for (auto const& plane : volume.planes) {
+      // corner furthest along the plane normal
+      glm::fvec3 corner{plane.x >= 0.0f ? boxes.max_x[i] : boxes.min_x[i],
+                        plane.y >= 0.0f ? boxes.max_y[i] : boxes.min_y[i],
+                        plane.z >= 0.0f ? boxes.max_z[i] : boxes.min_z[i]};
+      inside = inside && glm::dot(glm::fvec3{plane}, corner) + plane.w >= 0.0f;
+    }
+    out[num_visible] = std::uint32_t(i);
+    num_visible += inside;
+  }
+  visible.resize(start + num_visible);
+  return num_visible;
+}
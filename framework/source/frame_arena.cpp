@@ -0,0 +1,85 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+// initial size of the arena used by the launcher
+const std::size_t FRAME_MEMORY_SIZE = 1 << 20;
+
+// offset of the next address with the given alignment
+static std::size_t align_offset(unsigned char const* base, std::size_t offset, std::size_t alignment) {
+  std::uintptr_t address = std::uintptr_t(base) + offset;
+  std::uintptr_t aligned = (address + alignment - 1) / alignment * alignment;
+  return offset + std::size_t(aligned - address);
+}
+
+frame_arena::frame_arena(std::size_t capacity)
+ :m_block{new unsigned char[capacity]}
+ ,m_overflow{}
+ ,m_capacity{capacity}
+ ,m_offset{0}
+ ,m_overflow_offset{0}
+ ,m_overflow_capacity{0}
+ ,m_used{0}
+ ,m_peak{0}
+{}
+
+void* frame_arena::allocate(std::size_t bytes, std::size_t alignment) {
+  if (m_overflow.empty()) {
+    std::size_t start = align_offset(m_block.get(), m_offset, alignment);
+    if (start + bytes <= m_capacity) {
+      m_used += start + bytes - m_offset;
+      m_offset = start + bytes;
+      m_peak = std::max(m_peak, m_used);
+      return m_block.get() + start;
+    }
+  }
+  else {
+    std::size_t start = align_offset(m_overflow.back().get(), m_overflow_offset, alignment);
+    if (start + bytes <= m_overflow_capacity) {
+      m_used += start + bytes - m_overflow_offset;
+      m_overflow_offset = start + bytes;
+      m_peak = std::max(m_peak, m_used);
+      return m_overflow.back().get() + start;
+    }
+  }
+  // frame needs more than the arena holds, fall back to the heap until the next reset
+  m_overflow_capacity = std::max(m_capacity, bytes + alignment);
+  m_overflow.emplace_back(new unsigned char[m_overflow_capacity]);
+  std::size_t start = align_offset(m_overflow.back().get(), 0, alignment);
+  m_overflow_offset = start + bytes;
+  m_used += m_overflow_offset;
+  m_peak = std::max(m_peak, m_used);
+  return m_overflow.back().get() + start;
+}
+
+void frame_arena::reset() {
+  if (!m_overflow.empty()) {
+    // grow to the largest frame so far, steady state frames never reach the heap
+    m_overflow.clear();
+    m_capacity = std::max(m_capacity * 2, m_peak);
+    m_block.reset(new unsigned char[m_capacity]);
+  }
+  m_offset = 0;
+  m_overflow_offset = 0;
+  m_overflow_capacity = 0;
+  m_used = 0;
+}
+
+std::size_t frame_arena::used() const {
+  return m_used;
+}
+
+std::size_t frame_arena::peak() const {
+  return m_peak;
+}
+
+std::size_t frame_arena::capacity() const {
+  return m_capacity;
+}
+
+frame_arena& frame_memory() {
+  // simulation and render thread fill their frames concurrently
+  thread_local frame_arena arena{FRAME_MEMORY_SIZE};
+  return arena;
+}
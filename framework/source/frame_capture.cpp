@@ -0,0 +1,325 @@
+#include "frame_capture.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+// one second, waiting on a readback longer means the gpu is hung
+const GLuint64 CAPTURE_FENCE_TIMEOUT = 1000000000;
+// encodings in flight per job system thread before capture waits for the oldest
+const std::size_t ENCODES_PER_THREAD = 2;
+// largest payload of an uncompressed deflate block
+const std::size_t STORED_BLOCK_SIZE = 65535;
+
+frame_capture::frame_capture(std::string const& path, format encoding, unsigned ring_size)
+ :m_path{path}
+ ,m_format{encoding}
+ ,m_video{}
+ ,m_width{0}
+ ,m_height{0}
+ ,m_ring(std::max(ring_size, 1u))
+ ,m_next{0}
+ ,m_captured{0}
+ ,m_stalled{0}
+ ,m_encodes{}
+ ,m_last_write{}
+ ,m_pool_mutex{}
+ ,m_pool{}
+{
+  if (m_format == RAW) {
+    m_video.open(m_path, std::ios::binary);
+    if (!m_video) {
+      throw std::runtime_error("Could not open " + m_path + " for writing");
+    }
+  }
+  for (readback& slot : m_ring) {
+    glGenBuffers(1, &slot.buffer);
+    slot.fence = nullptr;
+    slot.frame = 0;
+  }
+}
+
+frame_capture::~frame_capture() {
+  finish();
+  for (readback& slot : m_ring) {
+    glDeleteBuffers(1, &slot.buffer);
+  }
+}
+
+void frame_capture::capture(int width, int height) {
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  if (width != m_width || height != m_height) {
+    // pending readbacks still have the old size
+    finish();
+    m_width = width;
+    m_height = height;
+    for (readback& slot : m_ring) {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(width) * height * 4, nullptr, GL_STREAM_READ);
+    }
+  }
+
+  readback& slot = m_ring[m_next];
+  // ring is full, the oldest frame has to be read before its buffer is reused
+  if (slot.fence && !collect(slot, false)) {
+    ++m_stalled;
+    collect(slot, true);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  // rows are tightly packed
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  // returns immediately, the copy into the buffer happens on the gpu
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, UnusedMask::GL_UNUSED_BIT);
+  slot.frame = m_captured++;
+  m_next = (m_next + 1) % m_ring.size();
+
+  // hand over older frames that are already finished, in capture order
+  for (std::size_t i = 0; i + 1 < m_ring.size(); ++i) {
+    readback& older = m_ring[(m_next + i) % m_ring.size()];
+    if (older.fence && !collect(older, false)) {
+      break;
+    }
+  }
+}
+
+void frame_capture::finish() {
+  // oldest first, so raw frames are appended in order
+  for (std::size_t i = 0; i < m_ring.size(); ++i) {
+    readback& slot = m_ring[(m_next + i) % m_ring.size()];
+    if (slot.fence) {
+      collect(slot, true);
+    }
+  }
+  for (job_system::job_handle const& handle : m_encodes) {
+    job_system::instance().wait(handle);
+  }
+  m_encodes.clear();
+  if (m_video.is_open()) {
+    m_video.flush();
+  }
+}
+
+bool frame_capture::collect(readback& slot, bool wait) {
+  if (wait) {
+    // flush on first wait, otherwise the fence may never be submitted
+    GLenum result = glClientWaitSync(slot.fence, SyncObjectMask::GL_SYNC_FLUSH_COMMANDS_BIT, CAPTURE_FENCE_TIMEOUT);
+    while (result == GL_TIMEOUT_EXPIRED) {
+      result = glClientWaitSync(slot.fence, SyncObjectMask::GL_NONE_BIT, CAPTURE_FENCE_TIMEOUT);
+    }
+  }
+  else if (glClientWaitSync(slot.fence, SyncObjectMask::GL_NONE_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+    return false;
+  }
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+
+  // bound the memory of queued frames, the oldest encoding usually finished long ago
+  std::size_t max_encodes = job_system::instance().concurrency() * ENCODES_PER_THREAD;
+  while (!m_encodes.empty() && (job_system::instance().finished(m_encodes.front()) || m_encodes.size() >= max_encodes)) {
+    job_system::instance().wait(m_encodes.front());
+    m_encodes.pop_front();
+  }
+
+  std::shared_ptr<pixel_data> image = acquire_image();
+  image->width = std::size_t(m_width);
+  image->height = std::size_t(m_height);
+  image->pixels.resize(image->width * image->height * 4);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  void const* mapping = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(image->pixels.size()), GL_MAP_READ_BIT);
+  if (mapping) {
+    // the only copy on the gl thread, flipping and encoding happen on workers
+    std::memcpy(image->pixels.data(), mapping, image->pixels.size());
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  if (!mapping) {
+    std::cerr << "Mapping of captured frame " << slot.frame << " failed" << std::endl;
+    release_image(image);
+    return true;
+  }
+
+  std::size_t frame = slot.frame;
+  std::vector<job_system::job_handle> dependencies{};
+  if (m_format == RAW && m_last_write) {
+    dependencies.push_back(m_last_write);
+  }
+  job_system::job_handle handle = job_system::instance().submit([this, image, frame]() {
+    encode(image, frame);
+  }, dependencies);
+  if (m_format == RAW) {
+    m_last_write = handle;
+  }
+  m_encodes.push_back(handle);
+  return true;
+}
+
+void frame_capture::encode(std::shared_ptr<pixel_data> image, std::size_t frame) {
+  // gl rows start at the bottom
+  std::size_t row_size = image->width * 4;
+  for (std::size_t top = 0, bottom = image->height - 1; top < bottom; ++top, --bottom) {
+    std::swap_ranges(image->pixels.begin() + std::ptrdiff_t(top * row_size),
+                     image->pixels.begin() + std::ptrdiff_t((top + 1) * row_size),
+                     image->pixels.begin() + std::ptrdiff_t(bottom * row_size));
+  }
+  // jobs must not throw
+  try {
+    if (m_format == PNG) {
+      char number[16];
+      std::snprintf(number, sizeof(number), "%05zu", frame);
+      write_png(m_path + number + ".png", *image);
+    }
+    else {
+      m_video.write(reinterpret_cast<char const*>(image->pixels.data()), std::streamsize(image->pixels.size()));
+    }
+  }
+  catch (std::exception const& error) {
+    std::cerr << "Capture of frame " << frame << " failed: " << error.what() << std::endl;
+  }
+  release_image(image);
+}
+
+std::shared_ptr<pixel_data> frame_capture::acquire_image() {
+  std::lock_guard<std::mutex> lock{m_pool_mutex};
+  if (m_pool.empty()) {
+    std::shared_ptr<pixel_data> image = std::make_shared<pixel_data>();
+    image->channels = GL_RGBA;
+    image->channel_type = GL_UNSIGNED_BYTE;
+    image->depth = 1;
+    return image;
+  }
+  std::shared_ptr<pixel_data> image = m_pool.back();
+  m_pool.pop_back();
+  return image;
+}
+
+void frame_capture::release_image(std::shared_ptr<pixel_data> const& image) {
+  std::lock_guard<std::mutex> lock{m_pool_mutex};
+  m_pool.push_back(image);
+}
+
+std::size_t frame_capture::captured_frames() const {
+  return m_captured;
+}
+
+std::size_t frame_capture::stalled_frames() const {
+  return m_stalled;
+}
+
+// lookup table of the png checksum, built once on first use
+struct crc_table {
+  crc_table() {
+    for (std::uint32_t n = 0; n < 256; ++n) {
+      std::uint32_t c = n;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      values[n] = c;
+    }
+  }
+  std::uint32_t values[256];
+};
+
+// checksum of png chunks
+static std::uint32_t crc32(unsigned char const* data, std::size_t size) {
+  // initialization of local statics is thread safe, encoders run concurrently
+  static const crc_table table{};
+  std::uint32_t crc = 0xffffffffu;
+  for (std::size_t i = 0; i < size; ++i) {
+    crc = table.values[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+// checksum of the zlib stream
+static std::uint32_t adler32(unsigned char const* data, std::size_t size) {
+  std::uint32_t a = 1;
+  std::uint32_t b = 0;
+  while (size > 0) {
+    // largest run whose sums can not overflow before the modulo
+    std::size_t run = std::min(size, std::size_t(5552));
+    for (std::size_t i = 0; i < run; ++i) {
+      a += data[i];
+      b += a;
+    }
+    a %= 65521u;
+    b %= 65521u;
+    data += run;
+    size -= run;
+  }
+  return (b << 16) | a;
+}
+
+static void append_u32(std::vector<unsigned char>& out, std::uint32_t value) {
+  out.push_back(std::uint8_t(value >> 24));
+  out.push_back(std::uint8_t(value >> 16));
+  out.push_back(std::uint8_t(value >> 8));
+  out.push_back(std::uint8_t(value));
+}
+
+// length, type, data and checksum over type and data
+static void write_chunk(std::ofstream& file, char const* type, std::vector<unsigned char> const& data) {
+  std::vector<unsigned char> chunk{};
+  chunk.reserve(data.size() + 12);
+  append_u32(chunk, std::uint32_t(data.size()));
+  chunk.insert(chunk.end(), type, type + 4);
+  chunk.insert(chunk.end(), data.begin(), data.end());
+  append_u32(chunk, crc32(chunk.data() + 4, data.size() + 4));
+  file.write(reinterpret_cast<char const*>(chunk.data()), std::streamsize(chunk.size()));
+}
+
+void write_png(std::string const& file_name, pixel_data const& image) {
+  if (image.channels != GL_RGBA || image.channel_type != GL_UNSIGNED_BYTE) {
+    throw std::invalid_argument("Only GL_RGBA byte images can be written as png");
+  }
+  std::ofstream file{file_name, std::ios::binary};
+  if (!file) {
+    throw std::runtime_error("Could not open " + file_name + " for writing");
+  }
+  unsigned char const signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  file.write(reinterpret_cast<char const*>(signature), sizeof(signature));
+
+  std::vector<unsigned char> header{};
+  append_u32(header, std::uint32_t(image.width));
+  append_u32(header, std::uint32_t(image.height));
+  // 8 bit rgba, deflate, adaptive filtering, no interlace
+  unsigned char const format[5] = {8, 6, 0, 0, 0};
+  header.insert(header.end(), format, format + 5);
+  write_chunk(file, "IHDR", header);
+
+  // every row starts with filter type none
+  std::size_t row_size = image.width * 4;
+  std::vector<unsigned char> rows((row_size + 1) * image.height);
+  for (std::size_t y = 0; y < image.height; ++y) {
+    rows[y * (row_size + 1)] = 0;
+    std::memcpy(&rows[y * (row_size + 1) + 1], &image.pixels[y * row_size], row_size);
+  }
+
+  // zlib stream of stored deflate blocks, encoding speed matters more than file size
+  std::size_t blocks = std::max(std::size_t(1), (rows.size() + STORED_BLOCK_SIZE - 1) / STORED_BLOCK_SIZE);
+  std::vector<unsigned char> data{};
+  data.reserve(rows.size() + blocks * 5 + 6);
+  data.push_back(0x78);
+  data.push_back(0x01);
+  std::size_t offset = 0;
+  do {
+    std::size_t size = std::min(rows.size() - offset, STORED_BLOCK_SIZE);
+    // the last block is marked final
+    data.push_back(offset + size == rows.size() ? 1 : 0);
+    data.push_back(std::uint8_t(size));
+    data.push_back(std::uint8_t(size >> 8));
+    data.push_back(std::uint8_t(~size));
+    data.push_back(std::uint8_t(~size >> 8));
+    data.insert(data.end(), rows.begin() + std::ptrdiff_t(offset), rows.begin() + std::ptrdiff_t(offset + size));
+    offset += size;
+  } while (offset < rows.size());
+  append_u32(data, adler32(rows.data(), rows.size()));
+  write_chunk(file, "IDAT", data);
+  write_chunk(file, "IEND", std::vector<unsigned char>{});
+}
@@ -0,0 +1,174 @@
+#include "geometry_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+geometry_arena::geometry_arena(model::attrib_flag_t attributes, std::size_t vertex_bytes, std::size_t vertex_capacity, std::size_t index_capacity)
+ :m_attributes{attributes}
+ ,m_vertex_bytes{GLsizei(vertex_bytes)}
+ ,m_vertex_capacity{vertex_capacity}
+ ,m_index_capacity{index_capacity}
+ ,m_vertex_array{0}
+ ,m_vertex_buffer{0}
+ ,m_element_buffer{0}
+ ,m_free_vertices{block{0, vertex_capacity}}
+ ,m_free_indices{block{0, index_capacity}}
+ ,m_asset{0}
+{
+  glGenVertexArrays(1, &m_vertex_array);
+  glBindVertexArray(m_vertex_array);
+  glGenBuffers(1, &m_vertex_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+  glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(m_vertex_capacity) * m_vertex_bytes, nullptr, GL_STATIC_DRAW);
+  // element buffer binding is part of the vertex array state
+  glGenBuffers(1, &m_element_buffer);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_element_buffer);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(m_index_capacity * model::INDEX.size), nullptr, GL_STATIC_DRAW);
+  m_asset = asset_memory::instance().track("geometry arena free", "buffer");
+  update_asset();
+}
+
+geometry_arena::~geometry_arena() {
+  asset_memory::instance().untrack(m_asset);
+  glDeleteBuffers(1, &m_vertex_buffer);
+  glDeleteBuffers(1, &m_element_buffer);
+  glDeleteVertexArrays(1, &m_vertex_array);
+}
+
+geometry_arena::mesh_range geometry_arena::add(model const& mesh) {
+  // the layout is given by the attributes the model contains
+  if (mesh.attributes != m_attributes) {
+    throw std::invalid_argument("Vertex layout of model differs from geometry arena");
+  }
+
+  std::size_t first_vertex = 0;
+  std::size_t first_index = 0;
+  if (!allocate(m_free_vertices, mesh.vertex_num, first_vertex)) {
+    throw std::length_error("Geometry arena has no free range for " + std::to_string(mesh.vertex_num) + " vertices");
+  }
+  if (!allocate(m_free_indices, mesh.indices.size(), first_index)) {
+    release(m_free_vertices, first_vertex, mesh.vertex_num);
+    throw std::length_error("Geometry arena has no free range for " + std::to_string(mesh.indices.size()) + " indices");
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+  glBufferSubData(GL_ARRAY_BUFFER, GLintptr(first_vertex) * m_vertex_bytes, GLsizeiptr(sizeof(GLfloat) * mesh.data.size()), mesh.data.data());
+  // bind the vertex array, the element buffer binding would otherwise change the last bound one
+  glBindVertexArray(m_vertex_array);
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, GLintptr(first_index * model::INDEX.size), GLsizeiptr(mesh.indices.size() * model::INDEX.size), mesh.indices.data());
+
+  update_asset();
+  return mesh_range{GLint(first_vertex), GLsizei(mesh.vertex_num), first_index, GLsizei(mesh.indices.size())};
+}
+
+void geometry_arena::remove(mesh_range const& range) {
+  release(m_free_vertices, std::size_t(range.base_vertex), std::size_t(range.vertex_count));
+  release(m_free_indices, range.first_index, std::size_t(range.index_count));
+  update_asset();
+}
+
+GLuint geometry_arena::vertex_array() const {
+  return m_vertex_array;
+}
+
+void geometry_arena::draw(mesh_range const& range, GLenum mode) const {
+  glDrawElementsBaseVertex(mode, range.index_count, model::INDEX.type, (GLvoid*)(range.first_index * model::INDEX.size), range.base_vertex);
+}
+
+void geometry_arena::draw_instanced(mesh_range const& range, GLsizei instances, GLenum mode) const {
+  glDrawElementsInstancedBaseVertex(mode, range.index_count, model::INDEX.type, (GLvoid*)(range.first_index * model::INDEX.size),
+                                    instances, range.base_vertex);
+}
+
+std::size_t geometry_arena::bytes(mesh_range const& range) const {
+  return std::size_t(range.vertex_count) * std::size_t(m_vertex_bytes) + std::size_t(range.index_count) * model::INDEX.size;
+}
+
+geometry_arena::usage geometry_arena::report() const {
+  usage result{};
+  result.vertex_capacity = m_vertex_capacity;
+  result.index_capacity = m_index_capacity;
+  result.vertices_used = m_vertex_capacity - free_space(m_free_vertices);
+  result.indices_used = m_index_capacity - free_space(m_free_indices);
+  result.free_blocks = m_free_vertices.size() + m_free_indices.size();
+  result.vertex_fragmentation = fragmentation(m_free_vertices);
+  result.index_fragmentation = fragmentation(m_free_indices);
+  return result;
+}
+
+void geometry_arena::print_usage(std::ostream& stream) const {
+  usage current = report();
+  stream << "Geometry arena: "
+         << current.vertices_used << "/" << current.vertex_capacity << " vertices, "
+         << current.indices_used << "/" << current.index_capacity << " indices, "
+         << current.free_blocks << " free blocks, fragmentation "
+         << current.vertex_fragmentation * 100.0f << "% vertices "
+         << current.index_fragmentation * 100.0f << "% indices" << std::endl;
+}
+
+bool geometry_arena::allocate(std::vector<block>& free_blocks, std::size_t count, std::size_t& first) {
+  for (auto it = free_blocks.begin(); it != free_blocks.end(); ++it) {
+    if (it->count < count) {
+      continue;
+    }
+    first = it->first;
+    it->first += count;
+    it->count -= count;
+    if (it->count == 0) {
+      free_blocks.erase(it);
+    }
+    return true;
+  }
+  return false;
+}
+
+void geometry_arena::release(std::vector<block>& free_blocks, std::size_t first, std::size_t count) {
+  if (count == 0) {
+    return;
+  }
+  auto next = std::lower_bound(free_blocks.begin(), free_blocks.end(), first, [](block const& candidate, std::size_t position) {
+    return candidate.first < position;
+  });
+  next = free_blocks.insert(next, block{first, count});
+  // merge with following block
+  auto after = next + 1;
+  if (after != free_blocks.end() && next->first + next->count == after->first) {
+    next->count += after->count;
+    free_blocks.erase(after);
+  }
+  // merge with preceding block
+  if (next != free_blocks.begin()) {
+    auto before = next - 1;
+    if (before->first + before->count == next->first) {
+      before->count += next->count;
+      free_blocks.erase(next);
+    }
+  }
+}
+
+std::size_t geometry_arena::free_space(std::vector<block> const& free_blocks) {
+  std::size_t total = 0;
+  for (block const& candidate : free_blocks) {
+    total += candidate.count;
+  }
+  return total;
+}
+
+float geometry_arena::fragmentation(std::vector<block> const& free_blocks) {
+  std::size_t total = free_space(free_blocks);
+  if (total == 0) {
+    return 0.0f;
+  }
+  std::size_t largest = 0;
+  for (block const& candidate : free_blocks) {
+    largest = std::max(largest, candidate.count);
+  }
+  return 1.0f - float(largest) / float(total);
+}
+
+void geometry_arena::update_asset() const {
+  asset_memory::instance().set_gpu_bytes(m_asset, free_space(m_free_vertices) * std::size_t(m_vertex_bytes)
+                                                + free_space(m_free_indices) * model::INDEX.size);
+}
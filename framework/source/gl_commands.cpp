@@ -0,0 +1,96 @@
+#include "gl_commands.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <glm/gtc/type_ptr.hpp>
+
+static GLenum gl_primitive(command::primitive mode) {
+  switch (mode) {
+    case command::POINTS:
+      return GL_POINTS;
+    case command::LINES:
+      return GL_LINES;
+    default:
+      return GL_TRIANGLES;
+  }
+}
+
+static GLenum gl_buffer_target(command::buffer_target target) {
+  switch (target) {
+    case command::ELEMENT_BUFFER:
+      return GL_ELEMENT_ARRAY_BUFFER;
+    case command::UNIFORM_BUFFER:
+      return GL_UNIFORM_BUFFER;
+    default:
+      return GL_ARRAY_BUFFER;
+  }
+}
+
+namespace gl_commands {
+void execute(command_buffer const& commands) {
+  command_reader reader{commands};
+  while (reader.next()) {
+    switch (reader.kind()) {
+      case command::USE_PROGRAM:
+        glUseProgram(reader.payload<command::use_program>().program);
+        break;
+      case command::BIND_VERTEX_ARRAY:
+        glBindVertexArray(reader.payload<command::bind_vertex_array>().vertex_array);
+        break;
+      case command::BIND_BUFFER: {
+        command::bind_buffer bind = reader.payload<command::bind_buffer>();
+        glBindBuffer(gl_buffer_target(bind.target), bind.buffer);
+        break;
+      }
+      case command::UNIFORM_MATRIX: {
+        command::uniform_matrix uniform = reader.payload<command::uniform_matrix>();
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(uniform.value));
+        break;
+      }
+      case command::UNIFORM_VECTOR: {
+        command::uniform_vector uniform = reader.payload<command::uniform_vector>();
+        glUniform4fv(uniform.location, 1, glm::value_ptr(uniform.value));
+        break;
+      }
+      case command::ATTRIBUTE_POINTER: {
+        command::attribute_pointer attribute = reader.payload<command::attribute_pointer>();
+        glVertexAttribPointer(attribute.location, GLint(attribute.components), GL_FLOAT, GL_FALSE, GLsizei(attribute.stride),
+                              reinterpret_cast<GLvoid const*>(std::uintptr_t(attribute.offset)));
+        break;
+      }
+      case command::ATTRIBUTE_CONSTANT: {
+        command::attribute_constant attribute = reader.payload<command::attribute_constant>();
+        glVertexAttrib4fv(attribute.location, glm::value_ptr(attribute.value));
+        break;
+      }
+      case command::DRAW_ARRAYS: {
+        command::draw_arrays draw = reader.payload<command::draw_arrays>();
+        glDrawArrays(gl_primitive(draw.mode), draw.first, draw.count);
+        break;
+      }
+      case command::MULTI_DRAW_ARRAYS: {
+        command::multi_draw_arrays draw = reader.payload<command::multi_draw_arrays>();
+        // ranges directly follow the header struct, which keeps them four byte aligned
+        GLint const* firsts = reinterpret_cast<GLint const*>(reader.trailing(sizeof(draw)));
+        glMultiDrawArrays(gl_primitive(draw.mode), firsts, firsts + draw.range_count, GLsizei(draw.range_count));
+        break;
+      }
+      case command::DRAW_INDEXED: {
+        command::draw_indexed draw = reader.payload<command::draw_indexed>();
+        glDrawElementsInstancedBaseVertex(gl_primitive(draw.mode), draw.index_count, GL_UNSIGNED_INT,
+                                          reinterpret_cast<GLvoid const*>(std::uintptr_t(draw.first_index * sizeof(GLuint))),
+                                          draw.instances, draw.base_vertex);
+        break;
+      }
+    }
+  }
+}
+
+void execute(command_stream const& stream) {
+  for (std::size_t i = 0; i < stream.size(); ++i) {
+    execute(stream.buffer(i));
+  }
+}
+}
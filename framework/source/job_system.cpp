@@ -0,0 +1,198 @@
+#include "job_system.hpp"
+
+// pool the calling thread belongs to and index of its queue
+thread_local job_system const* current_pool = nullptr;
+thread_local std::size_t current_queue = 0;
+
+job_system::job_system(unsigned worker_count)
+ :m_queues{}
+ ,m_workers{}
+ ,m_main_thread{std::this_thread::get_id()}
+ ,m_main_mutex{}
+ ,m_main_jobs{}
+ ,m_sleep_mutex{}
+ ,m_wake{}
+ ,m_queued{0}
+ ,m_stop{false}
+{
+  if (worker_count == 0) {
+    worker_count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+  }
+  // first queue is shared by all threads outside of the pool
+  for (unsigned i = 0; i <= worker_count; ++i) {
+    m_queues.emplace_back(new job_queue{});
+  }
+  for (unsigned i = 1; i <= worker_count; ++i) {
+    m_workers.emplace_back(&job_system::worker_loop, this, std::size_t(i));
+  }
+}
+
+job_system::~job_system() {
+  {
+    std::lock_guard<std::mutex> lock{m_sleep_mutex};
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (std::thread& worker : m_workers) {
+    worker.join();
+  }
+}
+
+job_system& job_system::instance() {
+  static job_system pool{};
+  return pool;
+}
+
+unsigned job_system::concurrency() const {
+  return unsigned(m_workers.size()) + 1;
+}
+
+job_system::job_handle job_system::submit(std::function<void()> work, std::vector<job_handle> const& dependencies) {
+  return create(std::move(work), false, dependencies);
+}
+
+job_system::job_handle job_system::submit_main(std::function<void()> work, std::vector<job_handle> const& dependencies) {
+  return create(std::move(work), true, dependencies);
+}
+
+job_system::job_handle job_system::create(std::function<void()> work, bool main_thread, std::vector<job_handle> const& dependencies) {
+  job_handle handle = std::make_shared<job>();
+  handle->work = std::move(work);
+  handle->main_thread = main_thread;
+  // extra count prevents scheduling while dependencies are still registered
+  handle->pending = 1;
+  handle->done = false;
+  for (job_handle const& dependency : dependencies) {
+    std::lock_guard<std::mutex> lock{dependency->mutex};
+    if (!dependency->done) {
+      ++handle->pending;
+      dependency->continuations.push_back(handle);
+    }
+  }
+  if (--handle->pending == 0) {
+    schedule(handle);
+  }
+  return handle;
+}
+
+void job_system::schedule(job_handle const& handle) {
+  if (handle->main_thread) {
+    std::lock_guard<std::mutex> lock{m_main_mutex};
+    m_main_jobs.push_back(handle);
+    return;
+  }
+  {
+    job_queue& queue = *m_queues[queue_index()];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    queue.jobs.push_back(handle);
+  }
+  {
+    // taking the lock orders the count with a worker going to sleep, no wakeup is lost
+    std::lock_guard<std::mutex> lock{m_sleep_mutex};
+    ++m_queued;
+  }
+  m_wake.notify_one();
+}
+
+void job_system::execute(job_handle const& handle) {
+  handle->work();
+  // release captured state early, handles may outlive the job for a long time
+  handle->work = nullptr;
+  std::vector<job_handle> continuations{};
+  {
+    std::lock_guard<std::mutex> lock{handle->mutex};
+    handle->done = true;
+    continuations.swap(handle->continuations);
+  }
+  for (job_handle const& continuation : continuations) {
+    if (--continuation->pending == 0) {
+      schedule(continuation);
+    }
+  }
+}
+
+std::size_t job_system::queue_index() const {
+  return current_pool == this ? current_queue : 0;
+}
+
+bool job_system::run_one() {
+  if (m_queued == 0) {
+    return false;
+  }
+  std::size_t own = queue_index();
+  job_handle handle{};
+  // newest own job first, its data is most likely still in cache
+  {
+    job_queue& queue = *m_queues[own];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (!queue.jobs.empty()) {
+      handle = queue.jobs.back();
+      queue.jobs.pop_back();
+    }
+  }
+  // oldest job of another queue, usually the largest remaining piece of work
+  for (std::size_t i = 1; !handle && i < m_queues.size(); ++i) {
+    job_queue& queue = *m_queues[(own + i) % m_queues.size()];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (!queue.jobs.empty()) {
+      handle = queue.jobs.front();
+      queue.jobs.pop_front();
+    }
+  }
+  if (!handle) {
+    return false;
+  }
+  --m_queued;
+  execute(handle);
+  return true;
+}
+
+void job_system::worker_loop(std::size_t index) {
+  current_pool = this;
+  current_queue = index;
+  while (!m_stop) {
+    if (run_one()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock{m_sleep_mutex};
+    m_wake.wait(lock, [this]() {
+      return m_stop || m_queued > 0;
+    });
+  }
+}
+
+void job_system::wait(job_handle const& handle) {
+  bool main_thread = std::this_thread::get_id() == m_main_thread;
+  while (!handle->done) {
+    if (run_one()) {
+      continue;
+    }
+    // the awaited job may depend on main thread work
+    if (main_thread && run_main_jobs() > 0) {
+      continue;
+    }
+    // remaining jobs are running on other threads
+    std::this_thread::yield();
+  }
+}
+
+bool job_system::finished(job_handle const& handle) const {
+  return handle->done;
+}
+
+std::size_t job_system::run_main_jobs() {
+  std::vector<job_handle> ready{};
+  {
+    std::lock_guard<std::mutex> lock{m_main_mutex};
+    ready.swap(m_main_jobs);
+  }
+  // jobs released by these are run in the next call
+  for (job_handle const& handle : ready) {
+    execute(handle);
+  }
+  return ready.size();
+}
+
+void job_system::set_main_thread() {
+  m_main_thread = std::this_thread::get_id();
+}
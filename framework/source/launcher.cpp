@@ -17,47 +17,182 @@
 
 #include "utils.hpp"
 #include "shader_loader.hpp"
-
+#include "job_system.hpp"
+#include "frame_arena.hpp"
+#include "asset_memory.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
 
 // use gl definitions from glbinding 
 using namespace gl;
 
 // helper functions
-std::string resourcePath(int argc, char* argv[]);
+std::string resourcePath(std::string const& exe_path);
 void glsl_error(int error, const char* description);
 void watch_gl_errors(bool activate = true);
+void count_draw_calls(unsigned* counter);
 
 Launcher::Launcher(int argc, char* argv[]) 
  :m_camera_fov{glm::radians(60.0f)}
  ,m_window_width{640u}
  ,m_window_height{480u}
  ,m_window{nullptr}
+ ,m_headless{false}
+ ,m_frame_limit{0u}
+ ,m_framebuffer{0u}
+ ,m_color_buffer{0u}
+ ,m_depth_buffer{0u}
+ ,m_frame_samples{}
+ ,m_draw_calls{0u}
+ ,m_fixed_clock{false}
+ ,m_render_thread{false}
+ ,m_frame_mutex{}
+ ,m_frame_signal{}
+ ,m_published_frames{0u}
+ ,m_acquired_frames{0u}
+ ,m_lockstep{false}
+ ,m_simulation_done{false}
+ ,m_simulation_samples{}
+ ,m_render_memory_peak{0u}
+ ,m_capture_path{}
+ ,m_capture_format{frame_capture::PNG}
+ ,m_capture{}
+ ,m_framebuffer_width{0}
+ ,m_framebuffer_height{0}
+ ,m_frame_index{0u}
+ ,m_input_timeline{}
+ ,m_next_input{0u}
+ ,m_record_path{}
+ ,m_report_path{}
+ ,m_recorded_input{}
  ,m_last_second_time{0.0}
  ,m_frames_per_second{0u}
- ,m_resource_path{resourcePath(argc, argv)}
+ ,m_time_step{1.0 / 60.0}
+ ,m_max_frame_time{0.25}
+ ,m_max_steps{240u}
+ ,m_time_scale{1.0}
+ ,m_time_accumulator{0.0}
+ ,m_resource_path{}
  ,m_application{}
-{}
+{
+  parse_arguments(argc, argv);
+}
 
-std::string resourcePath(int argc, char* argv[]) {
-  std::string resource_path{};
-  //first argument is resource path
-  if (argc > 1) {
-    resource_path = argv[1];
+// usage: <exe> [resource path] [--headless] [--size <width>x<height>] [--frames <n>]
+//              [--fixed-clock] [--render-thread] [--replay <file>] [--record <file>] [--report <file>]
+//              [--capture <path>] [--capture-format <png|raw>] [--evict-cpu-copies]
+void Launcher::parse_arguments(int argc, char* argv[]) {
+  std::string replay_path{};
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    // render offscreen in hidden window
+    if (arg == "--headless") {
+      m_headless = true;
+    }
+    // window or offscreen resolution
+    else if (arg == "--size" && i + 1 < argc) {
+      std::string size{argv[++i]};
+      std::size_t separator = size.find('x');
+      if (separator == std::string::npos) {
+        throw std::invalid_argument("--size expects <width>x<height>, got " + size);
+      }
+      m_window_width = unsigned(std::stoul(size.substr(0, separator)));
+      m_window_height = unsigned(std::stoul(size.substr(separator + 1)));
+    }
+    // quit after fixed number of frames
+    else if (arg == "--frames" && i + 1 < argc) {
+      m_frame_limit = unsigned(std::stoul(argv[++i]));
+    }
+    // simulate one time step per frame, independent from wall clock
+    else if (arg == "--fixed-clock") {
+      m_fixed_clock = true;
+    }
+    // render on a separate thread
+    else if (arg == "--render-thread") {
+      m_render_thread = true;
+    }
+    // replay key events from file
+    else if (arg == "--replay" && i + 1 < argc) {
+      replay_path = argv[++i];
+    }
+    // record key events to file
+    else if (arg == "--record" && i + 1 < argc) {
+      m_record_path = argv[++i];
+    }
+    // write frame statistics to file instead of stdout
+    else if (arg == "--report" && i + 1 < argc) {
+      m_report_path = argv[++i];
+    }
+    // write every rendered frame to files starting with the path, or to the path as raw video
+    else if (arg == "--capture" && i + 1 < argc) {
+      m_capture_path = argv[++i];
+    }
+    else if (arg == "--capture-format" && i + 1 < argc) {
+      std::string format{argv[++i]};
+      if (format == "png") {
+        m_capture_format = frame_capture::PNG;
+      }
+      else if (format == "raw") {
+        m_capture_format = frame_capture::RAW;
+      }
+      else {
+        throw std::invalid_argument("--capture-format expects png or raw, got " + format);
+      }
+    }
+    // free cpu copies of assets after upload, set before the application loads anything
+    else if (arg == "--evict-cpu-copies") {
+      asset_memory::instance().set_policy(asset_memory::EVICT_CPU_COPIES);
+    }
+    // first positional argument is resource path
+    else if (arg.compare(0, 2, "--") != 0 && m_resource_path.empty()) {
+      m_resource_path = arg;
+    }
+    else {
+      std::cerr << "Unknown argument \'" << arg << "\'" << std::endl;
+    }
   }
   // no resource path specified, use default
-  else {
-    std::string exe_path{argv[0]};
-    resource_path = exe_path.substr(0, exe_path.find_last_of("/\\"));
-    resource_path += "/../../resources/";
+  if (m_resource_path.empty()) {
+    m_resource_path = resourcePath(argv[0]);
+  }
+  // headless rendering without frame limit would never terminate
+  if (m_headless && m_frame_limit == 0) {
+    m_frame_limit = 1000;
+  }
+  if (m_frame_limit > 0) {
+    m_frame_samples.reserve(m_frame_limit);
+    if (m_render_thread) {
+      m_simulation_samples.reserve(m_frame_limit);
+    }
   }
+  if (!replay_path.empty()) {
+    // timelines shipped with the resources can be given relative to them
+    if (!std::ifstream{replay_path} && std::ifstream{m_resource_path + replay_path}) {
+      replay_path = m_resource_path + replay_path;
+    }
+    m_input_timeline = benchmark::read_input_timeline(replay_path);
+  }
+}
+
+std::string resourcePath(std::string const& exe_path) {
+  std::string resource_path = exe_path.substr(0, exe_path.find_last_of("/\\"));
+  resource_path += "/../../resources/";
 
   return resource_path;
 }
 
 void Launcher::initialize() {
+  // the thread creating the job system executes its main thread jobs
+  job_system::instance();
 
   glfwSetErrorCallback(glsl_error);
 
@@ -65,9 +200,9 @@ void Launcher::initialize() {
     std::exit(EXIT_FAILURE);
   }
 
-  // set OGL version explicitly 
+  // set OGL version explicitly, instanced arrays need 3.3
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, true);
   //MacOS requires core profile
   #ifdef __APPLE__
@@ -75,8 +210,12 @@ void Launcher::initialize() {
   #else
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE);
   #endif
+  // context still requires a window, keep it invisible when headless
+  if (m_headless) {
+    glfwWindowHint(GLFW_VISIBLE, 0);
+  }
   // create m_window, if unsuccessfull, quit
-  m_window = glfwCreateWindow(m_window_width, m_window_height, "OpenGL Framework", NULL, NULL);
+  m_window = glfwCreateWindow(int(m_window_width), int(m_window_height), "OpenGL Framework", NULL, NULL);
   if (!m_window) {
     glfwTerminate();
     std::exit(EXIT_FAILURE);
@@ -100,44 +239,331 @@ void Launcher::initialize() {
   };
   glfwSetScrollCallback(m_window, mouse_scroll_func);
   // allow free mouse movement
-  glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+  if (!m_headless) {
+    glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+  }
   // register resizing function
   auto resize_func = [](GLFWwindow* w, int a, int b) {
-        static_cast<Launcher*>(glfwGetWindowUserPointer(w))->update_projection(w, a, b);
+        Launcher* launcher = static_cast<Launcher*>(glfwGetWindowUserPointer(w));
+        launcher->on_gl_thread([launcher, w, a, b]() {
+          launcher->update_projection(w, a, b);
+        });
   };
   glfwSetFramebufferSizeCallback(m_window, resize_func);
 
   // initialize glindings in this context
   glbinding::Binding::initialize();
 
-  // activate error checking after each gl function call
-  watch_gl_errors();
+  if (m_frame_limit > 0) {
+    // error checking after each call would distort timings
+    count_draw_calls(&m_draw_calls);
+  }
+  else {
+    // activate error checking after each gl function call
+    watch_gl_errors();
+  }
+
+  if (m_headless) {
+    create_framebuffer();
+  }
+}
+
+void Launcher::create_framebuffer() {
+  GLsizei width = GLsizei(m_window_width);
+  GLsizei height = GLsizei(m_window_height);
+  // color attachment
+  glGenRenderbuffers(1, &m_color_buffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, m_color_buffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  // depth attachment
+  glGenRenderbuffers(1, &m_depth_buffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, m_depth_buffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+  glGenFramebuffers(1, &m_framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color_buffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depth_buffer);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    throw std::runtime_error("Offscreen framebuffer incomplete");
+  }
+  // framebuffer stays bound for all rendering
+}
+
+void Launcher::get_framebuffer_size(int& width, int& height) const {
+  if (m_headless) {
+    width = int(m_window_width);
+    height = int(m_window_height);
+  }
+  else {
+    glfwGetFramebufferSize(m_window, &width, &height);
+  }
 }
  
 void Launcher::mainLoop() {
   // do before framebuffer_resize call as it requires the projection uniform location
   // throw exception if shader compilation was unsuccessfull
   update_shader_programs(true);
+  int width, height;
+  get_framebuffer_size(width, height);
+  update_projection(m_window, width, height);
 
   // enable depth testing
   glEnable(GL_DEPTH_TEST);
   glDepthFunc(GL_LESS);
-  
-  // rendering loop
+
+  if (!m_capture_path.empty()) {
+    m_capture.reset(new frame_capture{m_capture_path, m_capture_format});
+  }
+
+  // render on the main thread if the application reads live state in render
+  if (m_render_thread && !m_application->renders_snapshots()) {
+    std::cerr << "Application does not render snapshots, rendering on the main thread" << std::endl;
+    m_render_thread = false;
+  }
+
+  if (m_render_thread) {
+    threaded_loop();
+  }
+  else {
+    double last_frame_time = glfwGetTime();
+    // rendering loop
+    while (!glfwWindowShouldClose(m_window)) {
+      if (m_frame_limit > 0 && m_frame_index >= m_frame_limit) {
+        break;
+      }
+      benchmark::frame_sample sample{};
+      m_draw_calls = 0;
+      // sample time only once per frame
+      double current_time = glfwGetTime();
+      double poll_start = benchmark::thread_cpu_time();
+      // query input
+      glfwPollEvents();
+      replay_input();
+      double poll_end = benchmark::thread_cpu_time();
+      sample.poll = poll_end - poll_start;
+
+      update_simulation(m_fixed_clock ? m_time_step : current_time - last_frame_time);
+      last_frame_time = current_time;
+      m_application->publish();
+      m_application->acquire();
+      // gl work queued by jobs, like uploads of data prepared on other threads
+      job_system::instance().run_main_jobs();
+      sample.update = benchmark::thread_cpu_time() - poll_end;
+
+      render_frame(sample);
+      sample.total = glfwGetTime() - current_time;
+
+      if (m_frame_limit > 0) {
+        m_frame_samples.push_back(sample);
+      }
+      // display fps
+      show_fps(current_time);
+      // transient data of this frame is no longer referenced
+      frame_memory().reset();
+      ++m_frame_index;
+    }
+  }
+
+  if (m_capture) {
+    // frames still in flight are written before the report
+    m_capture->finish();
+  }
+  if (!m_record_path.empty()) {
+    benchmark::write_input_timeline(m_record_path, m_recorded_input);
+  }
+  if (m_frame_limit > 0) {
+    write_report();
+  }
+  quit(EXIT_SUCCESS);
+}
+
+// main thread of threaded rendering, polls input, simulates and publishes snapshots
+void Launcher::threaded_loop() {
+  // benchmarks and replays render every simulated frame, so samples and input line up with frames,
+  // otherwise the simulation runs ahead and the render thread draws the latest snapshot
+  m_lockstep = m_frame_limit > 0 || !m_input_timeline.empty();
+  // the context can only be current on one thread
+  glfwMakeContextCurrent(nullptr);
+  std::thread renderer{&Launcher::render_loop, this};
+
+  double last_frame_time = glfwGetTime();
   while (!glfwWindowShouldClose(m_window)) {
-    // query input
+    if (m_frame_limit > 0 && m_frame_index >= m_frame_limit) {
+      break;
+    }
+    benchmark::frame_sample sample{};
+    double current_time = glfwGetTime();
+    double poll_start = benchmark::thread_cpu_time();
     glfwPollEvents();
-    // clear buffer
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    // draw geometry
-    m_application->render();
+    replay_input();
+    double poll_end = benchmark::thread_cpu_time();
+    sample.poll = poll_end - poll_start;
+
+    update_simulation(m_fixed_clock ? m_time_step : current_time - last_frame_time);
+    last_frame_time = current_time;
+    m_application->publish();
+    sample.update = benchmark::thread_cpu_time() - poll_end;
+    if (m_frame_limit > 0) {
+      m_simulation_samples.push_back(sample);
+    }
+
+    {
+      std::unique_lock<std::mutex> lock{m_frame_mutex};
+      ++m_published_frames;
+      m_frame_signal.notify_all();
+      if (m_lockstep) {
+        // continue with the next frame once this one is acquired, so no published frame is replaced before it was rendered
+        m_frame_signal.wait(lock, [this]() {
+          return m_acquired_frames == m_published_frames;
+        });
+      }
+    }
+    show_fps(current_time);
+    frame_memory().reset();
+    ++m_frame_index;
+    if (!m_lockstep) {
+      // a snapshot per time step is enough, the render thread picks up the latest one whenever it is ready
+      double remaining = m_time_step - (glfwGetTime() - current_time);
+      if (remaining > 0.0) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(remaining));
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{m_frame_mutex};
+    m_simulation_done = true;
+  }
+  m_frame_signal.notify_all();
+  renderer.join();
+
+  // take the context back to free resources
+  glfwMakeContextCurrent(m_window);
+  glbinding::Binding::useCurrentContext();
+  job_system::instance().set_main_thread();
+  // gl work queued after the last rendered frame
+  job_system::instance().run_main_jobs();
+
+  // render thread measured the frames, the main thread its poll and update time
+  std::size_t merged = std::min(m_frame_samples.size(), m_simulation_samples.size());
+  for (std::size_t i = 0; i < merged; ++i) {
+    m_frame_samples[i].poll = m_simulation_samples[i].poll;
+    m_frame_samples[i].update = m_simulation_samples[i].update;
+  }
+}
+
+// render thread, owns the gl context until the main thread stops simulating
+void Launcher::render_loop() {
+  glfwMakeContextCurrent(m_window);
+  // glbinding keeps the current context per thread
+  glbinding::Binding::useCurrentContext();
+  // gl work of jobs and callbacks is run here from now on
+  job_system::instance().set_main_thread();
+
+  double last_frame_end = glfwGetTime();
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{m_frame_mutex};
+      m_frame_signal.wait(lock, [this]() {
+        return m_acquired_frames < m_published_frames || m_simulation_done;
+      });
+      // render every published frame before stopping
+      if (m_acquired_frames == m_published_frames) {
+        break;
+      }
+    }
+    benchmark::frame_sample sample{};
+    m_draw_calls = 0;
+    // the latest snapshot replaces frames published since the last acquire,
+    // in lockstep the snapshot is taken before the main thread is released, so it can not be overwritten
+    m_application->acquire();
+    {
+      std::lock_guard<std::mutex> lock{m_frame_mutex};
+      m_acquired_frames = m_published_frames;
+    }
+    m_frame_signal.notify_all();
+
+    // shader reloads and resizes requested by the main thread
+    job_system::instance().run_main_jobs();
+    render_frame(sample);
+    double frame_end = glfwGetTime();
+    // time between presented frames, simulation is overlapped
+    sample.total = frame_end - last_frame_end;
+    last_frame_end = frame_end;
+    if (m_frame_limit > 0) {
+      m_frame_samples.push_back(sample);
+    }
+    // every thread has its own frame memory
+    frame_memory().reset();
+  }
+  m_render_memory_peak = frame_memory().peak();
+  glfwMakeContextCurrent(nullptr);
+}
+
+void Launcher::render_frame(benchmark::frame_sample& sample) {
+  double render_start = benchmark::thread_cpu_time();
+  // clear buffer
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // draw geometry
+  m_application->render();
+  double render_end = benchmark::thread_cpu_time();
+  sample.render = render_end - render_start;
+
+  if (m_capture) {
+    // only queues the readback, frames are encoded on the job system
+    m_capture->capture(m_framebuffer_width, m_framebuffer_height);
+  }
+  if (m_headless) {
+    // no swap to pace frames, wait for completion to measure actual cost
+    glFinish();
+  }
+  else {
     // swap draw buffer to front
     glfwSwapBuffers(m_window);
-    // display fps
-    show_fps();
   }
+  sample.present = benchmark::thread_cpu_time() - render_end;
+  sample.draw_calls = m_draw_calls;
+}
 
-  quit(EXIT_SUCCESS);
+void Launcher::on_gl_thread(std::function<void()> const& work) {
+  if (m_render_thread) {
+    job_system::instance().submit_main(work);
+  }
+  else {
+    work();
+  }
+}
+
+// dispatch recorded key events as if they were just polled
+void Launcher::replay_input() {
+  while (m_next_input < m_input_timeline.size()
+      && m_input_timeline[m_next_input].frame <= m_frame_index) {
+    benchmark::input_event const& event = m_input_timeline[m_next_input];
+    key_callback(m_window, event.key, 0, event.action, event.mods);
+    ++m_next_input;
+  }
+}
+
+// advance simulation in fixed steps, independent from render cadence
+void Launcher::update_simulation(double frame_time) {
+  // clamp to prevent huge catch-up after stalls like window dragging
+  frame_time = std::min(frame_time, m_max_frame_time);
+  m_time_accumulator += frame_time * m_time_scale;
+
+  unsigned steps = 0;
+  while (m_time_accumulator >= m_time_step && steps < m_max_steps) {
+    m_application->update(m_time_step);
+    m_time_accumulator -= m_time_step;
+    ++steps;
+  }
+  // simulation cannot keep up with time warp, drop the backlog to stay stable
+  if (steps == m_max_steps) {
+    m_time_accumulator = std::fmod(m_time_accumulator, m_time_step);
+  }
+  // render state between previous and current step
+  m_application->setFrameInterpolation(float(m_time_accumulator / m_time_step));
 }
 
 ///////////////////////////// update functions ////////////////////////////////
@@ -145,6 +571,8 @@ void Launcher::mainLoop() {
 void Launcher::update_projection(GLFWwindow* m_window, int width, int height) {
   // resize framebuffer
   glViewport(0, 0, width, height);
+  m_framebuffer_width = width;
+  m_framebuffer_height = height;
 
   float aspect = float(width) / float(height);
   float fov_y = m_camera_fov;
@@ -188,21 +616,39 @@ void Launcher::update_shader_programs(bool throwing) {
 
   // after shader programs are recompiled, uniform locations may change
   m_application->uploadUniforms();
-  
-  // upload projection matrix to new shaders
-  int width, height;
-  glfwGetFramebufferSize(m_window, &width, &height);
-  update_projection(m_window, width, height);
 }
 
 ///////////////////////////// misc functions ////////////////////////////////
 // handle key input
 void Launcher::key_callback(GLFWwindow* m_window, int key, int scancode, int action, int mods) {
+  if (!m_record_path.empty()) {
+    m_recorded_input.push_back(benchmark::input_event{m_frame_index, key, action, mods});
+  }
   if ((key == GLFW_KEY_ESCAPE || key == GLFW_KEY_Q) && action == GLFW_PRESS) {
     glfwSetWindowShouldClose(m_window, 1);
   }
   else if (key == GLFW_KEY_R && action == GLFW_PRESS) {
-    update_shader_programs(false);
+    // size is queried here, glfw only allows it on the main thread
+    int width, height;
+    get_framebuffer_size(width, height);
+    on_gl_thread([this, m_window, width, height]() {
+      update_shader_programs(false);
+      // upload projection matrix to new shaders
+      update_projection(m_window, width, height);
+    });
+  }
+  // speed up or slow down simulated time
+  else if (key == GLFW_KEY_EQUAL && action == GLFW_PRESS) {
+    m_time_scale *= 2.0;
+  }
+  else if (key == GLFW_KEY_MINUS && action == GLFW_PRESS) {
+    m_time_scale *= 0.5;
+  }
+  else if (key == GLFW_KEY_0 && action == GLFW_PRESS) {
+    m_time_scale = 1.0;
+  }
+  else if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+    asset_memory::instance().print(std::cout);
   }
   m_application->keyCallback(key, scancode, action, mods);
 }
@@ -213,12 +659,20 @@ void Launcher::mouse_scroll_callback(GLFWwindow* m_window, double x, double y)
 }
 
 // calculate fps and show in m_window title
-void Launcher::show_fps() {
+void Launcher::show_fps(double current_time) {
   ++m_frames_per_second;
-  double current_time = glfwGetTime();
   if (current_time - m_last_second_time >= 1.0) {
-    std::string title{"OpenGL Framework - "};
-    title += std::to_string(m_frames_per_second) + " fps";
+    // formatted into frame memory, building the title never touches the heap
+    char number[32];
+    frame_string title{"OpenGL Framework - "};
+    std::snprintf(number, sizeof(number), "%u", m_frames_per_second);
+    title += number;
+    title += " fps";
+    if (m_time_scale != 1.0) {
+      std::snprintf(number, sizeof(number), "%g", m_time_scale);
+      title += " - time x";
+      title += number;
+    }
 
     glfwSetWindowTitle(m_window, title.c_str());
     m_frames_per_second = 0;
@@ -226,9 +680,47 @@ void Launcher::show_fps() {
   }
 }
 
+// output frame statistics as json
+void Launcher::write_report() const {
+  std::ofstream file_out{};
+  if (!m_report_path.empty()) {
+    file_out.open(m_report_path);
+    if (!file_out) {
+      std::cerr << "Could not write report to \'" << m_report_path << "\'" << std::endl;
+    }
+  }
+  std::ostream& out = file_out.is_open() ? file_out : std::cout;
+
+  benchmark::json_writer json{out};
+  json.begin_object();
+  json.key("resolution").begin_array();
+  json.value(m_window_width);
+  json.value(m_window_height);
+  json.end_array();
+  json.key("headless").value(m_headless);
+  json.key("fixed_clock").value(m_fixed_clock);
+  json.key("time_step").value(m_time_step);
+  json.key("render_thread").value(m_render_thread);
+  json.key("frame_memory_peak").value(std::max(frame_memory().peak(), m_render_memory_peak));
+  if (m_capture) {
+    json.key("captured_frames").value(m_capture->captured_frames());
+    json.key("capture_stalls").value(m_capture->stalled_frames());
+  }
+  json.key("assets");
+  asset_memory::instance().write(json);
+  json.key("statistics");
+  benchmark::write_frame_report(json, m_frame_samples);
+  json.end_object();
+}
+
 void Launcher::quit(int status) {
   // free opengl resources
   delete m_application;
+  // writes the remaining captured frames
+  m_capture.reset();
+  glDeleteFramebuffers(1, &m_framebuffer);
+  glDeleteRenderbuffers(1, &m_color_buffer);
+  glDeleteRenderbuffers(1, &m_depth_buffer);
   // free glfw resources
   glfwDestroyWindow(m_window);
   glfwTerminate();
@@ -241,6 +733,22 @@ void glsl_error(int error, const char* description) {
   std::cerr << "GLSL Error " << error << " : "<< description << std::endl;
 }
 
+// count calls of all draw functions
+void count_draw_calls(unsigned* counter) {
+  glbinding::setCallbackMask(glbinding::CallbackMask::None);
+  for (glbinding::AbstractFunction* function : glbinding::Binding::functions()) {
+    std::string name{function->name()};
+    if (name.compare(0, 6, "glDraw") == 0 || name.compare(0, 11, "glMultiDraw") == 0) {
+      function->setCallbackMask(glbinding::CallbackMask::After);
+    }
+  }
+  glbinding::setAfterCallback(
+    [counter](glbinding::FunctionCall const&) {
+      ++*counter;
+    }
+  );
+}
+
 void watch_gl_errors(bool activate) {
   if(activate) {
     // add callback after each function call
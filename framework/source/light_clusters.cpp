@@ -0,0 +1,151 @@
+#include "light_clusters.hpp"
+#include "job_system.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+light_clusters::light_clusters(unsigned tiles_x, unsigned tiles_y, unsigned slices)
+ :m_tiles_x{tiles_x}
+ ,m_tiles_y{tiles_y}
+ ,m_slices{slices}
+ ,m_near{0.0f}
+ ,m_far{0.0f}
+ ,m_bounds{}
+ ,m_ranges(std::size_t(tiles_x) * tiles_y * slices, range{0, 0})
+ ,m_slice_indices(slices)
+ ,m_slice_candidates(slices)
+ ,m_indices{}
+{
+  if (tiles_x == 0 || tiles_y == 0 || slices == 0) {
+    throw std::invalid_argument("Light clusters need at least one tile and slice");
+  }
+}
+
+void light_clusters::set_projection(glm::fmat4 const& projection) {
+  // planes from the depth row of a gl perspective matrix
+  m_near = projection[3][2] / (projection[2][2] - 1.0f);
+  m_far = projection[3][2] / (projection[2][2] + 1.0f);
+  if (!(m_near > 0.0f && m_far > m_near)) {
+    throw std::invalid_argument("Light clusters need a perspective projection");
+  }
+
+  m_bounds.resize(cluster_count());
+  for (unsigned slice = 0; slice < m_slices; ++slice) {
+    float depths[2] = {m_near * std::pow(m_far / m_near, float(slice) / float(m_slices)),
+                       m_near * std::pow(m_far / m_near, float(slice + 1) / float(m_slices))};
+    for (unsigned y = 0; y < m_tiles_y; ++y) {
+      for (unsigned x = 0; x < m_tiles_x; ++x) {
+        float ndc_x[2] = {float(x) / float(m_tiles_x) * 2.0f - 1.0f, float(x + 1) / float(m_tiles_x) * 2.0f - 1.0f};
+        float ndc_y[2] = {float(y) / float(m_tiles_y) * 2.0f - 1.0f, float(y + 1) / float(m_tiles_y) * 2.0f - 1.0f};
+        // tile edges are planes through the eye, the box spans their points at both depths
+        aabb bounds{glm::fvec3{1e30f}, glm::fvec3{-1e30f}};
+        for (float depth : depths) {
+          for (unsigned corner = 0; corner < 4; ++corner) {
+            glm::fvec3 point{(ndc_x[corner & 1] + projection[2][0]) * depth / projection[0][0],
+                             (ndc_y[corner >> 1] + projection[2][1]) * depth / projection[1][1],
+                             -depth};
+            bounds.min = glm::min(bounds.min, point);
+            bounds.max = glm::max(bounds.max, point);
+          }
+        }
+        m_bounds[(std::size_t(slice) * m_tiles_y + y) * m_tiles_x + x] = bounds;
+      }
+    }
+  }
+}
+
+void light_clusters::assign(std::vector<point_light> const& lights, unsigned threads) {
+  if (m_bounds.empty()) {
+    throw std::logic_error("Light clusters need a projection before lights are assigned");
+  }
+  if (threads == 0) {
+    threads = job_system::instance().concurrency();
+  }
+  std::size_t grain = (m_slices + threads - 1) / threads;
+  // slices own disjoint ranges and lists, no synchronization needed
+  parallel_for(0, m_slices, grain, [&](std::size_t first, std::size_t last) {
+    for (std::size_t slice = first; slice < last; ++slice) {
+      assign_slice(slice, lights);
+    }
+  });
+
+  // move the slice lists behind each other
+  std::size_t total = 0;
+  for (std::vector<std::uint32_t> const& slice_indices : m_slice_indices) {
+    total += slice_indices.size();
+  }
+  m_indices.resize(total);
+  std::size_t slice_clusters = std::size_t(m_tiles_x) * m_tiles_y;
+  std::uint32_t base = 0;
+  for (std::size_t slice = 0; slice < m_slices; ++slice) {
+    std::vector<std::uint32_t> const& slice_indices = m_slice_indices[slice];
+    std::copy(slice_indices.begin(), slice_indices.end(), m_indices.begin() + std::ptrdiff_t(base));
+    for (std::size_t i = slice * slice_clusters; i < (slice + 1) * slice_clusters; ++i) {
+      m_ranges[i].first += base;
+    }
+    base += std::uint32_t(slice_indices.size());
+  }
+}
+
+void light_clusters::assign_slice(std::size_t slice, std::vector<point_light> const& lights) {
+  std::size_t slice_clusters = std::size_t(m_tiles_x) * m_tiles_y;
+  std::size_t first_cluster = slice * slice_clusters;
+  float slice_near = -m_bounds[first_cluster].max.z;
+  float slice_far = -m_bounds[first_cluster].min.z;
+
+  // lights reaching the depth range of the slice, tested against all of its clusters
+  std::vector<std::uint32_t>& candidates = m_slice_candidates[slice];
+  candidates.clear();
+  for (std::size_t l = 0; l < lights.size(); ++l) {
+    float depth = -lights[l].position.z;
+    if (depth + lights[l].radius >= slice_near && depth - lights[l].radius <= slice_far) {
+      candidates.push_back(std::uint32_t(l));
+    }
+  }
+
+  std::vector<std::uint32_t>& slice_indices = m_slice_indices[slice];
+  slice_indices.clear();
+  for (std::size_t cluster = first_cluster; cluster < first_cluster + slice_clusters; ++cluster) {
+    aabb const& bounds = m_bounds[cluster];
+    m_ranges[cluster].first = std::uint32_t(slice_indices.size());
+    for (std::uint32_t l : candidates) {
+      // sphere touches the box if its closest point lies inside the radius
+      glm::fvec3 closest = glm::clamp(lights[l].position, bounds.min, bounds.max);
+      glm::fvec3 offset = closest - lights[l].position;
+      if (glm::dot(offset, offset) <= lights[l].radius * lights[l].radius) {
+        slice_indices.push_back(l);
+      }
+    }
+    m_ranges[cluster].count = std::uint32_t(slice_indices.size()) - m_ranges[cluster].first;
+  }
+}
+
+std::vector<light_clusters::range> const& light_clusters::ranges() const {
+  return m_ranges;
+}
+
+std::vector<std::uint32_t> const& light_clusters::indices() const {
+  return m_indices;
+}
+
+glm::fvec3 light_clusters::grid() const {
+  return glm::fvec3{float(m_tiles_x), float(m_tiles_y), float(m_slices)};
+}
+
+glm::fvec2 light_clusters::depth_mapping() const {
+  float scale = float(m_slices) / std::log(m_far / m_near);
+  return glm::fvec2{scale, -std::log(m_near) * scale};
+}
+
+std::size_t light_clusters::cluster_count() const {
+  return m_ranges.size();
+}
+
+std::size_t light_clusters::max_lights_per_cluster() const {
+  std::uint32_t longest = 0;
+  for (range const& cluster : m_ranges) {
+    longest = std::max(longest, cluster.count);
+  }
+  return longest;
+}
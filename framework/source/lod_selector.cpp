@@ -0,0 +1,41 @@
+#include "lod_selector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+lod_selector::lod_selector(std::vector<float> thresholds, float hysteresis)
+ :m_thresholds(std::move(thresholds))
+ ,m_hysteresis{hysteresis}
+{
+  if (!std::is_sorted(m_thresholds.begin(), m_thresholds.end())) {
+    throw std::invalid_argument("Level of detail thresholds must be ascending");
+  }
+}
+
+unsigned lod_selector::select(float projected_size, unsigned current) const {
+  unsigned level = std::min(current, unsigned(m_thresholds.size()));
+  // the margins make the ranges overlap, at most one of both loops moves the level
+  while (level < m_thresholds.size() && projected_size >= m_thresholds[level] * (1.0f + m_hysteresis)) {
+    ++level;
+  }
+  while (level > 0 && projected_size < m_thresholds[level - 1] * (1.0f - m_hysteresis)) {
+    --level;
+  }
+  return level;
+}
+
+unsigned lod_selector::levels() const {
+  return unsigned(m_thresholds.size() + 1);
+}
+
+float lod_selector::projected_size(glm::fmat4 const& projection, float distance, float radius) {
+  if (distance <= radius) {
+    return std::numeric_limits<float>::max();
+  }
+  // tangent of the half angle the sphere covers, the projection scales it to half the viewport height
+  float tangent = radius / std::sqrt(distance * distance - radius * radius);
+  return tangent * projection[1][1];
+}
@@ -23,17 +23,25 @@ model::attribute const  model::INDEX{1 << 5, sizeof(unsigned),  1, GL_UNSIGNED_I
 model::model()
  :data{}
  ,indices{}
- ,offsets{}
+ ,attributes{0}
  ,vertex_bytes{0}
  ,vertex_num{0}
+ ,box_min{0.0f}
+ ,box_max{0.0f}
+ ,sphere_center{0.0f}
+ ,sphere_radius{0.0f}
 {}
 
 model::model(std::vector<GLfloat> const& databuff, attrib_flag_t contained_attributes, std::vector<GLuint> const& trianglebuff)
  :data(databuff)
  ,indices(trianglebuff)
- ,offsets{}
+ ,attributes{0}
  ,vertex_bytes{0}
  ,vertex_num{0}
+ ,box_min{0.0f}
+ ,box_max{0.0f}
+ ,sphere_center{0.0f}
+ ,sphere_radius{0.0f}
 {
   // number of components per vertex
   std::size_t component_num = 0;
@@ -41,9 +49,8 @@ model::model(std::vector<GLfloat> const& databuff, attrib_flag_t contained_attri
   for (auto const& supported_attribute : model::VERTEX_ATTRIBS) {
     // check if buffer contains attribute
     if (supported_attribute.flag & contained_attributes) {
-      // write offset, explicit cast to prevent narrowing warning
-      offsets.insert(std::pair<attrib_flag_t, GLvoid*>{supported_attribute, (GLvoid*)uintptr_t(vertex_bytes)});
-      // move offset pointer forward
+      attributes |= supported_attribute.flag;
+      // attributes are interleaved, the next one starts after it
       vertex_bytes += supported_attribute.size * supported_attribute.components;
       // increase number of components
       component_num += supported_attribute.components;
@@ -51,4 +58,28 @@ model::model(std::vector<GLfloat> const& databuff, attrib_flag_t contained_attri
   }
   // set number of vertice sin buffer
   vertex_num = data.size() / component_num;
-}
\ No newline at end of file
+}
+
+std::size_t model::offset(attribute const& attrib) const {
+  // sizes of the contained attributes before it
+  std::size_t result = 0;
+  for (auto const& supported_attribute : model::VERTEX_ATTRIBS) {
+    if (supported_attribute.flag == attrib.flag) {
+      break;
+    }
+    if (supported_attribute.flag & attributes) {
+      result += std::size_t(supported_attribute.size * supported_attribute.components);
+    }
+  }
+  return result;
+}
+
+std::size_t model::cpu_bytes() const {
+  return data.capacity() * sizeof(GLfloat) + indices.capacity() * sizeof(GLuint);
+}
+
+void model::release_cpu_copy() {
+  // swap with empty vectors, clear would keep the capacity
+  std::vector<GLfloat>{}.swap(data);
+  std::vector<GLuint>{}.swap(indices);
+}
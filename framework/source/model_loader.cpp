@@ -99,7 +99,36 @@ model obj(std::string const& name, model::attrib_flag_t import_attribs){
     vertex_offset += unsigned(curr_mesh.positions.size() / 3);
   }
 
-  return model{vertex_data, attributes, triangles};
+  model result{vertex_data, attributes, triangles};
+  compute_bounds(result);
+  return result;
+}
+
+void compute_bounds(model& mesh) {
+  if (mesh.vertex_num == 0) {
+    return;
+  }
+  // positions are the first attribute, stride in floats
+  std::size_t stride = std::size_t(mesh.vertex_bytes) / sizeof(float);
+  glm::fvec3 box_min{mesh.data[0], mesh.data[1], mesh.data[2]};
+  glm::fvec3 box_max{box_min};
+  for (std::size_t i = 0; i < mesh.vertex_num; ++i) {
+    glm::fvec3 position{mesh.data[i * stride], mesh.data[i * stride + 1], mesh.data[i * stride + 2]};
+    box_min = glm::min(box_min, position);
+    box_max = glm::max(box_max, position);
+  }
+  mesh.box_min = box_min;
+  mesh.box_max = box_max;
+
+  // sphere around box center, tighter than the box diagonal
+  mesh.sphere_center = (box_min + box_max) * 0.5f;
+  float radius_squared = 0.0f;
+  for (std::size_t i = 0; i < mesh.vertex_num; ++i) {
+    glm::fvec3 position{mesh.data[i * stride], mesh.data[i * stride + 1], mesh.data[i * stride + 2]};
+    glm::fvec3 offset = position - mesh.sphere_center;
+    radius_squared = glm::max(radius_squared, glm::dot(offset, offset));
+  }
+  mesh.sphere_radius = glm::sqrt(radius_squared);
 }
 
 void generate_normals(tinyobj::mesh_t& model) {
@@ -0,0 +1,258 @@
+#include "nbody.hpp"
+#include "star_field.hpp"
+#include "job_system.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// bodies up to which a node is not subdivided further
+const std::uint32_t LEAF_SIZE = 8;
+// limits subdivision of bodies at identical positions
+const unsigned MAX_DEPTH = 32;
+// every traversal step pushes at most 8 children, so this covers the maximum depth
+const std::size_t TRAVERSAL_STACK = 8 * MAX_DEPTH;
+// below this many bodies per job, scheduling is slower than computing
+const std::size_t MIN_BODIES_PER_JOB = 256;
+
+std::size_t nbody_system::add(glm::fvec3 const& position, glm::fvec3 const& velocity, float body_mass) {
+  std::size_t body = size();
+  x.push_back(position.x);
+  y.push_back(position.y);
+  z.push_back(position.z);
+  vx.push_back(velocity.x);
+  vy.push_back(velocity.y);
+  vz.push_back(velocity.z);
+  ax.push_back(0.0f);
+  ay.push_back(0.0f);
+  az.push_back(0.0f);
+  mass.push_back(body_mass);
+  return body;
+}
+
+std::size_t nbody_system::size() const {
+  return x.size();
+}
+
+///////////////////////////// barnes hut ////////////////////////////////
+barnes_hut::barnes_hut()
+ :m_nodes{}
+ ,m_order{}
+ ,m_source{}
+ ,m_points{}
+ ,m_scratch{}
+{}
+
+std::size_t barnes_hut::node_count() const {
+  return m_nodes.size();
+}
+
+// index of the child cube containing the point
+static unsigned octant(glm::fvec4 const& point, glm::fvec3 const& center) {
+  return unsigned(point.x >= center.x) | unsigned(point.y >= center.y) << 1 | unsigned(point.z >= center.z) << 2;
+}
+
+void barnes_hut::build(nbody_system const& bodies) {
+  std::size_t count = bodies.size();
+  m_nodes.clear();
+  m_order.resize(count);
+  m_source.resize(count);
+  m_points.resize(count);
+  m_scratch.resize(count);
+  if (count == 0) {
+    return;
+  }
+
+  glm::fvec3 box_min{bodies.x[0], bodies.y[0], bodies.z[0]};
+  glm::fvec3 box_max{box_min};
+  for (std::size_t i = 0; i < count; ++i) {
+    m_order[i] = std::uint32_t(i);
+    m_source[i] = glm::fvec4{bodies.x[i], bodies.y[i], bodies.z[i], bodies.mass[i]};
+    box_min = glm::min(box_min, glm::fvec3{m_source[i]});
+    box_max = glm::max(box_max, glm::fvec3{m_source[i]});
+  }
+  // cube around all bodies, slightly enlarged so points on the border are inside
+  glm::fvec3 extent = (box_max - box_min) * 0.5f;
+  float half_size = std::max(std::max(extent.x, extent.y), extent.z) * 1.001f + 1e-6f;
+  m_nodes.push_back(node{glm::fvec3{0.0f}, 0.0f, (box_min + box_max) * 0.5f, half_size, 0, 0, 0});
+  build_node(0, 0, std::uint32_t(count), 0);
+
+  for (std::size_t k = 0; k < count; ++k) {
+    m_points[k] = m_source[m_order[k]];
+  }
+}
+
+void barnes_hut::build_node(std::uint32_t node_index, std::uint32_t first, std::uint32_t count, unsigned depth) {
+  glm::fvec3 center = m_nodes[node_index].center;
+  float half_size = m_nodes[node_index].half_size;
+
+  if (count <= LEAF_SIZE || depth >= MAX_DEPTH) {
+    glm::fvec3 weighted{0.0f};
+    float mass = 0.0f;
+    for (std::uint32_t k = first; k < first + count; ++k) {
+      glm::fvec4 const& point = m_source[m_order[k]];
+      weighted += glm::fvec3{point} * point.w;
+      mass += point.w;
+    }
+    node& leaf = m_nodes[node_index];
+    leaf.first = first;
+    leaf.count = count;
+    leaf.mass = mass;
+    leaf.center_of_mass = mass > 0.0f ? weighted / mass : center;
+    return;
+  }
+
+  // counting sort of the range by octant
+  std::uint32_t octant_count[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  for (std::uint32_t k = first; k < first + count; ++k) {
+    ++octant_count[octant(m_source[m_order[k]], center)];
+  }
+  std::uint32_t octant_first[8];
+  octant_first[0] = first;
+  for (unsigned o = 1; o < 8; ++o) {
+    octant_first[o] = octant_first[o - 1] + octant_count[o - 1];
+  }
+  std::uint32_t target[8];
+  std::copy(octant_first, octant_first + 8, target);
+  for (std::uint32_t k = first; k < first + count; ++k) {
+    m_scratch[target[octant(m_source[m_order[k]], center)]++] = m_order[k];
+  }
+  std::copy(m_scratch.begin() + first, m_scratch.begin() + first + count, m_order.begin() + first);
+
+  // children of a node are stored contiguously, empty octants get no node
+  std::uint32_t child_first = std::uint32_t(m_nodes.size());
+  float child_half = half_size * 0.5f;
+  for (unsigned o = 0; o < 8; ++o) {
+    if (octant_count[o] == 0) {
+      continue;
+    }
+    glm::fvec3 offset{o & 1 ? child_half : -child_half, o & 2 ? child_half : -child_half, o & 4 ? child_half : -child_half};
+    m_nodes.push_back(node{glm::fvec3{0.0f}, 0.0f, center + offset, child_half, 0, 0, 0});
+  }
+  std::uint32_t children = std::uint32_t(m_nodes.size()) - child_first;
+  m_nodes[node_index].first = child_first;
+  m_nodes[node_index].children = children;
+
+  std::uint32_t child = child_first;
+  for (unsigned o = 0; o < 8; ++o) {
+    if (octant_count[o] > 0) {
+      build_node(child++, octant_first[o], octant_count[o], depth + 1);
+    }
+  }
+
+  glm::fvec3 weighted{0.0f};
+  float mass = 0.0f;
+  for (std::uint32_t c = child_first; c < child_first + children; ++c) {
+    weighted += m_nodes[c].center_of_mass * m_nodes[c].mass;
+    mass += m_nodes[c].mass;
+  }
+  node& inner = m_nodes[node_index];
+  inner.mass = mass;
+  inner.center_of_mass = mass > 0.0f ? weighted / mass : center;
+}
+
+void barnes_hut::accelerate_range(nbody_system& bodies, gravity_settings const& settings, std::size_t first, std::size_t last) const {
+  float softening_squared = settings.softening * settings.softening;
+  float angle_squared = settings.opening_angle * settings.opening_angle;
+  std::uint32_t stack[TRAVERSAL_STACK];
+
+  for (std::size_t k = first; k < last; ++k) {
+    glm::fvec3 position{m_points[k]};
+    glm::fvec3 acceleration{0.0f};
+    std::size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+      node const& current = m_nodes[stack[--top]];
+      if (current.children == 0) {
+        // leaf bodies are summed directly
+        for (std::uint32_t j = current.first; j < current.first + current.count; ++j) {
+          if (j == k) {
+            continue;
+          }
+          glm::fvec3 offset = glm::fvec3{m_points[j]} - position;
+          float inverse = 1.0f / std::sqrt(glm::dot(offset, offset) + softening_squared);
+          acceleration += offset * (m_points[j].w * inverse * inverse * inverse);
+        }
+        continue;
+      }
+      glm::fvec3 offset = current.center_of_mass - position;
+      float distance_squared = glm::dot(offset, offset);
+      float size = current.half_size * 2.0f;
+      if (size * size < angle_squared * distance_squared) {
+        // far enough away to act as a single mass
+        float inverse = 1.0f / std::sqrt(distance_squared + softening_squared);
+        acceleration += offset * (current.mass * inverse * inverse * inverse);
+      }
+      else {
+        for (std::uint32_t c = current.first; c < current.first + current.children; ++c) {
+          stack[top++] = c;
+        }
+      }
+    }
+    std::uint32_t body = m_order[k];
+    bodies.ax[body] = acceleration.x * settings.gravity;
+    bodies.ay[body] = acceleration.y * settings.gravity;
+    bodies.az[body] = acceleration.z * settings.gravity;
+  }
+}
+
+void barnes_hut::accelerate(nbody_system& bodies, gravity_settings const& settings) const {
+  std::size_t count = m_points.size();
+  std::size_t grain = 0;
+  if (settings.threads == 0) {
+    // more chunks than threads, so stealing balances the uneven cost of dense and sparse regions
+    grain = count / (job_system::instance().concurrency() * 4);
+  }
+  else {
+    // one chunk per thread limits the parallelism
+    grain = (count + settings.threads - 1) / settings.threads;
+  }
+  // chunks are contiguous in tree order, so neighbouring bodies share the traversed nodes
+  parallel_for(0, count, std::max(grain, MIN_BODIES_PER_JOB), [&](std::size_t first, std::size_t last) {
+    accelerate_range(bodies, settings, first, last);
+  });
+}
+
+///////////////////////////// integration ////////////////////////////////
+// change velocities by the accelerations over the given time
+static void kick(nbody_system& bodies, float delta_time) {
+  for (std::size_t i = 0; i < bodies.size(); ++i) {
+    bodies.vx[i] += bodies.ax[i] * delta_time;
+    bodies.vy[i] += bodies.ay[i] * delta_time;
+    bodies.vz[i] += bodies.az[i] * delta_time;
+  }
+}
+
+void leapfrog_step(nbody_system& bodies, barnes_hut& tree, gravity_settings const& settings, float delta_time) {
+  kick(bodies, delta_time * 0.5f);
+  // drift
+  for (std::size_t i = 0; i < bodies.size(); ++i) {
+    bodies.x[i] += bodies.vx[i] * delta_time;
+    bodies.y[i] += bodies.vy[i] * delta_time;
+    bodies.z[i] += bodies.vz[i] * delta_time;
+  }
+  tree.build(bodies);
+  tree.accelerate(bodies, settings);
+  kick(bodies, delta_time * 0.5f);
+}
+
+void add_ring(nbody_system& bodies, std::uint32_t seed, std::size_t count, glm::fvec3 const& center, glm::fvec3 const& center_velocity,
+              float central_mass, float inner_radius, float outer_radius, float thickness, float body_mass, float gravity) {
+  const float two_pi = 6.28318530718f;
+  for (std::size_t i = 0; i < count; ++i) {
+    std::uint32_t counter = std::uint32_t(i) * 3;
+    // uniform density over the ring area
+    float radius_squared = inner_radius * inner_radius + (outer_radius * outer_radius - inner_radius * inner_radius) * random_unit(seed, counter);
+    float radius = std::sqrt(radius_squared);
+    float angle = two_pi * random_unit(seed, counter + 1);
+    float height = (random_unit(seed, counter + 2) * 2.0f - 1.0f) * thickness;
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    // same direction of rotation as the circular orbits
+    float speed = std::sqrt(gravity * central_mass / radius);
+    glm::fvec3 position = center + glm::fvec3{c * radius, height, -s * radius};
+    glm::fvec3 velocity = center_velocity + glm::fvec3{-s, 0.0f, -c} * speed;
+    bodies.add(position, velocity, body_mass);
+  }
+}
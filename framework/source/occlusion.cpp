@@ -0,0 +1,255 @@
+#include "occlusion.hpp"
+#include "job_system.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+  #define OCCLUSION_SSE
+  #include <xmmintrin.h>
+#endif
+
+// smaller bands cost more in repeated triangle rejection than they gain in parallelism
+const std::size_t MIN_ROWS_PER_JOB = 8;
+
+occlusion_buffer::occlusion_buffer(std::size_t width, std::size_t height)
+ :m_width{(std::max(width, std::size_t(4)) + 3) / 4 * 4}
+ ,m_height{std::max(height, std::size_t(1))}
+ ,m_view_projection{}
+ ,m_triangles{}
+ ,m_screen{}
+ ,m_clipped{}
+ ,m_levels{}
+ ,m_level_widths{}
+ ,m_level_heights{}
+{
+  std::size_t level_width = m_width;
+  std::size_t level_height = m_height;
+  while (true) {
+    m_levels.emplace_back(level_width * level_height, 1.0f);
+    m_level_widths.push_back(level_width);
+    m_level_heights.push_back(level_height);
+    if (level_width == 1 && level_height == 1) {
+      break;
+    }
+    level_width = (level_width + 1) / 2;
+    level_height = (level_height + 1) / 2;
+  }
+}
+
+void occlusion_buffer::begin(glm::fmat4 const& view_projection) {
+  m_view_projection = view_projection;
+  m_triangles.clear();
+}
+
+void occlusion_buffer::add_occluder(glm::fmat4 const& model_matrix, float const* positions, std::size_t vertex_count, std::size_t stride,
+                                    std::uint32_t const* indices, std::size_t index_count) {
+  glm::fmat4 transform = m_view_projection * model_matrix;
+  m_screen.resize(vertex_count);
+  m_clipped.resize(vertex_count);
+  for (std::size_t i = 0; i < vertex_count; ++i) {
+    float const* position = positions + i * stride;
+    glm::fvec4 clip = transform * glm::fvec4{position[0], position[1], position[2], 1.0f};
+    // in front of the near plane, the projection would flip the vertex
+    m_clipped[i] = clip.z < -clip.w || clip.w <= 0.0f;
+    if (m_clipped[i]) {
+      continue;
+    }
+    glm::fvec3 ndc{clip / clip.w};
+    m_screen[i] = glm::fvec3{(ndc.x * 0.5f + 0.5f) * float(m_width),
+                             (0.5f - ndc.y * 0.5f) * float(m_height),
+                             ndc.z * 0.5f + 0.5f};
+  }
+
+  for (std::size_t i = 0; i + 2 < index_count; i += 3) {
+    std::uint32_t a = indices[i];
+    std::uint32_t b = indices[i + 1];
+    std::uint32_t c = indices[i + 2];
+    // dropping a triangle only makes culling less aggressive
+    if (m_clipped[a] || m_clipped[b] || m_clipped[c]) {
+      continue;
+    }
+    glm::fvec3 corners[3] = {m_screen[a], m_screen[b], m_screen[c]};
+    // both windings are rasterized, depth testing keeps the nearest surface
+    raster_triangle setup{};
+    int order[3];
+    float area;
+    if (!setup_raster_triangle(corners, m_width, m_height, setup, order, area)) {
+      continue;
+    }
+    m_triangles.push_back(setup);
+  }
+}
+
+void occlusion_buffer::finish(unsigned threads) {
+  if (threads == 0) {
+    threads = job_system::instance().concurrency();
+  }
+  std::size_t grain = std::max(MIN_ROWS_PER_JOB, (m_height + threads - 1) / threads);
+  // bands write disjoint rows, no synchronization needed
+  parallel_for(0, m_height, grain, [this](std::size_t first, std::size_t last) {
+    rasterize(first, last);
+  });
+  build_pyramid();
+}
+
+void occlusion_buffer::rasterize(std::size_t first_row, std::size_t last_row) {
+  std::vector<float>& depth = m_levels[0];
+  std::fill(depth.begin() + first_row * m_width, depth.begin() + last_row * m_width, 1.0f);
+
+  for (raster_triangle const& tri : m_triangles) {
+    int min_y = std::max(tri.min_y, int(first_row));
+    int max_y = std::min(tri.max_y, int(last_row) - 1);
+    if (min_y > max_y) {
+      continue;
+    }
+    // whole blocks of four pixels, the width is a multiple of four
+    int min_x = tri.min_x & ~3;
+    int max_x = tri.max_x;
+
+#ifdef OCCLUSION_SSE
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const lane_offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    __m128 edge_step[3];
+    for (int edge = 0; edge < 3; ++edge) {
+      edge_step[edge] = _mm_set1_ps(tri.edge_dx[edge] * 4.0f);
+    }
+    __m128 depth_step = _mm_set1_ps(tri.depth.y * 4.0f);
+    __m128 start_x = _mm_add_ps(_mm_set1_ps(float(min_x)), lane_offsets);
+
+    for (int y = min_y; y <= max_y; ++y) {
+      float center_y = float(y) + 0.5f;
+      __m128 edge_value[3];
+      for (int edge = 0; edge < 3; ++edge) {
+        edge_value[edge] = _mm_add_ps(_mm_mul_ps(start_x, _mm_set1_ps(tri.edge_dx[edge])),
+                                      _mm_set1_ps(tri.edge_c[edge] + tri.edge_dy[edge] * center_y));
+      }
+      __m128 depth_value = _mm_add_ps(_mm_mul_ps(start_x, _mm_set1_ps(tri.depth.y)),
+                                      _mm_set1_ps(tri.depth.x + tri.depth.z * center_y));
+      float* row = depth.data() + std::size_t(y) * m_width;
+      for (int x = min_x; x <= max_x; x += 4) {
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge_value[0], zero), _mm_cmpge_ps(edge_value[1], zero)),
+                                   _mm_cmpge_ps(edge_value[2], zero));
+        if (_mm_movemask_ps(inside)) {
+          __m128 previous = _mm_loadu_ps(row + x);
+          __m128 nearest = _mm_min_ps(previous, depth_value);
+          _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+        }
+        for (int edge = 0; edge < 3; ++edge) {
+          edge_value[edge] = _mm_add_ps(edge_value[edge], edge_step[edge]);
+        }
+        depth_value = _mm_add_ps(depth_value, depth_step);
+      }
+    }
+#else
+    for (int y = min_y; y <= max_y; ++y) {
+      float center_y = float(y) + 0.5f;
+      float* row = depth.data() + std::size_t(y) * m_width;
+      for (int x = min_x; x <= max_x; ++x) {
+        float center_x = float(x) + 0.5f;
+        bool inside = true;
+        for (int edge = 0; edge < 3; ++edge) {
+          inside = inside && tri.edge_c[edge] + tri.edge_dx[edge] * center_x + tri.edge_dy[edge] * center_y >= 0.0f;
+        }
+        if (inside) {
+          row[x] = std::min(row[x], tri.depth.x + tri.depth.y * center_x + tri.depth.z * center_y);
+        }
+      }
+    }
+#endif
+  }
+}
+
+void occlusion_buffer::build_pyramid() {
+  for (std::size_t level = 1; level < m_levels.size(); ++level) {
+    std::vector<float> const& fine = m_levels[level - 1];
+    std::vector<float>& coarse = m_levels[level];
+    std::size_t fine_width = m_level_widths[level - 1];
+    std::size_t fine_height = m_level_heights[level - 1];
+    for (std::size_t y = 0; y < m_level_heights[level]; ++y) {
+      // odd sizes repeat the last row or column
+      std::size_t y0 = y * 2;
+      std::size_t y1 = std::min(y0 + 1, fine_height - 1);
+      for (std::size_t x = 0; x < m_level_widths[level]; ++x) {
+        std::size_t x0 = x * 2;
+        std::size_t x1 = std::min(x0 + 1, fine_width - 1);
+        // farthest depth, a box behind it is behind everything in the region
+        coarse[y * m_level_widths[level] + x] = std::max(std::max(fine[y0 * fine_width + x0], fine[y0 * fine_width + x1]),
+                                                         std::max(fine[y1 * fine_width + x0], fine[y1 * fine_width + x1]));
+      }
+    }
+  }
+}
+
+bool occlusion_buffer::visible(aabb const& box) const {
+  float min_x = 1e30f;
+  float max_x = -1e30f;
+  float min_y = 1e30f;
+  float max_y = -1e30f;
+  float min_depth = 1e30f;
+  for (int corner = 0; corner < 8; ++corner) {
+    glm::fvec4 clip = m_view_projection * glm::fvec4{corner & 1 ? box.max.x : box.min.x,
+                                                     corner & 2 ? box.max.y : box.min.y,
+                                                     corner & 4 ? box.max.z : box.min.z, 1.0f};
+    if (clip.z < -clip.w || clip.w <= 0.0f) {
+      return true;
+    }
+    glm::fvec3 ndc{clip / clip.w};
+    float x = (ndc.x * 0.5f + 0.5f) * float(m_width);
+    float y = (0.5f - ndc.y * 0.5f) * float(m_height);
+    min_x = std::min(min_x, x);
+    max_x = std::max(max_x, x);
+    min_y = std::min(min_y, y);
+    max_y = std::max(max_y, y);
+    min_depth = std::min(min_depth, ndc.z * 0.5f + 0.5f);
+  }
+  // outside of the screen is the job of frustum culling
+  if (max_x < 0.0f || max_y < 0.0f || min_x >= float(m_width) || min_y >= float(m_height)) {
+    return true;
+  }
+
+  // covered pixels, inclusive
+  std::size_t first_x = std::size_t(std::max(min_x, 0.0f));
+  std::size_t last_x = std::size_t(std::min(max_x, float(m_width - 1)));
+  std::size_t first_y = std::size_t(std::max(min_y, 0.0f));
+  std::size_t last_y = std::size_t(std::min(max_y, float(m_height - 1)));
+  // finest level at which the rectangle overlaps at most four texels in each direction,
+  // two would often reach past the occluder silhouette
+  std::size_t level = 0;
+  while (level + 1 < m_levels.size() && ((last_x >> level) - (first_x >> level) > 3 || (last_y >> level) - (first_y >> level) > 3)) {
+    ++level;
+  }
+
+  std::vector<float> const& depth = m_levels[level];
+  std::size_t level_width = m_level_widths[level];
+  float farthest = 0.0f;
+  for (std::size_t y = first_y >> level; y <= last_y >> level; ++y) {
+    for (std::size_t x = first_x >> level; x <= last_x >> level; ++x) {
+      farthest = std::max(farthest, depth[y * level_width + x]);
+    }
+  }
+  return min_depth <= farthest;
+}
+
+std::size_t occlusion_buffer::cull(std::vector<aabb> const& boxes, std::vector<std::uint32_t>& indices) const {
+  indices.erase(std::remove_if(indices.begin(), indices.end(), [&](std::uint32_t index) {
+    return !visible(boxes[index]);
+  }), indices.end());
+  return indices.size();
+}
+
+std::size_t occlusion_buffer::width() const {
+  return m_width;
+}
+
+std::size_t occlusion_buffer::height() const {
+  return m_height;
+}
+
+std::vector<float> const& occlusion_buffer::depth() const {
+  return m_levels[0];
+}
+
+std::size_t occlusion_buffer::triangle_count() const {
+  return m_triangles.size();
+}
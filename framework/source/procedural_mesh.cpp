@@ -0,0 +1,144 @@
+#include "procedural_mesh.hpp"
+#include "model_loader.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+const float PI = 3.14159265358979f;
+// directions closer to the seam plane or the poles lie on them, grid points there are exact zeros
+const float SEAM_EPSILON = 1e-6f;
+
+// corner of an emitted triangle
+struct sphere_corner {
+  glm::fvec3 direction;
+  glm::fvec2 uv;
+};
+
+// spherical texture coordinates of a triangle, u wraps at the half plane x < 0, z = 0
+// corners on the seam take the side of the other corners, poles the mean u of the others
+static void sphere_texcoords(sphere_corner* corners) {
+  bool on_seam[3];
+  bool on_pole[3];
+  bool far_side = false;
+  for (unsigned i = 0; i < 3; ++i) {
+    glm::fvec3 const& d = corners[i].direction;
+    on_pole[i] = std::abs(d.x) < SEAM_EPSILON && std::abs(d.z) < SEAM_EPSILON;
+    on_seam[i] = !on_pole[i] && d.x < 0.0f && std::abs(d.z) < SEAM_EPSILON;
+    float u = on_seam[i] ? 0.0f : 0.5f + std::atan2(-d.z, d.x) / (2.0f * PI);
+    float v = 0.5f + std::asin(glm::clamp(d.y, -1.0f, 1.0f)) / PI;
+    corners[i].uv = glm::fvec2{u, v};
+    far_side = far_side || (!on_seam[i] && !on_pole[i] && u > 0.5f);
+  }
+  float u_sum = 0.0f;
+  unsigned u_count = 0;
+  for (unsigned i = 0; i < 3; ++i) {
+    if (on_seam[i] && far_side) {
+      corners[i].uv.x = 1.0f;
+    }
+    if (!on_pole[i]) {
+      u_sum += corners[i].uv.x;
+      ++u_count;
+    }
+  }
+  for (unsigned i = 0; i < 3; ++i) {
+    if (on_pole[i] && u_count > 0) {
+      corners[i].uv.x = u_sum / float(u_count);
+    }
+  }
+}
+
+model cube_sphere(unsigned subdivisions, model::attrib_flag_t attributes) {
+  // odd counts would put the seam and the poles inside quads
+  if (subdivisions == 0 || subdivisions % 2 != 0) {
+    throw std::invalid_argument("Cube sphere needs an even number of subdivisions, got " + std::to_string(subdivisions));
+  }
+  attributes = (attributes | model::POSITION) & (model::POSITION | model::NORMAL | model::TEXCOORD);
+  bool has_normals = (attributes & model::NORMAL) != 0;
+  bool has_uvs = (attributes & model::TEXCOORD) != 0;
+
+  std::vector<GLfloat> vertex_data{};
+  std::vector<GLuint> triangles{};
+  // corners with equal position and texture coordinates share one vertex
+  std::map<std::array<float, 5>, GLuint> vertices{};
+  auto emit = [&](sphere_corner const& corner) {
+    std::array<float, 5> key{{corner.direction.x, corner.direction.y, corner.direction.z,
+                              has_uvs ? corner.uv.x : 0.0f, has_uvs ? corner.uv.y : 0.0f}};
+    auto found = vertices.find(key);
+    if (found != vertices.end()) {
+      triangles.push_back(found->second);
+      return;
+    }
+    GLuint index = GLuint(vertices.size());
+    vertices.emplace(key, index);
+    triangles.push_back(index);
+    // unit sphere, position and normal are the same
+    vertex_data.insert(vertex_data.end(), {corner.direction.x, corner.direction.y, corner.direction.z});
+    if (has_normals) {
+      vertex_data.insert(vertex_data.end(), {corner.direction.x, corner.direction.y, corner.direction.z});
+    }
+    if (has_uvs) {
+      vertex_data.insert(vertex_data.end(), {corner.uv.x, corner.uv.y});
+    }
+  };
+
+  std::size_t side = subdivisions + 1;
+  std::vector<glm::fvec3> grid(side * side);
+  for (unsigned axis = 0; axis < 3; ++axis) {
+    for (float sign : {1.0f, -1.0f}) {
+      glm::fvec3 normal{0.0f};
+      normal[axis] = sign;
+      glm::fvec3 tangent{0.0f};
+      tangent[(axis + 1) % 3] = 1.0f;
+      glm::fvec3 bitangent{0.0f};
+      bitangent[(axis + 2) % 3] = 1.0f;
+      for (std::size_t row = 0; row < side; ++row) {
+        for (std::size_t column = 0; column < side; ++column) {
+          // equal angles instead of equal distances on the cube face, center lines are exact zeros
+          float a = std::tan((float(2 * column) / float(subdivisions) - 1.0f) * PI * 0.25f);
+          float b = std::tan((float(2 * row) / float(subdivisions) - 1.0f) * PI * 0.25f);
+          if (2 * column == subdivisions) {
+            a = 0.0f;
+          }
+          if (2 * row == subdivisions) {
+            b = 0.0f;
+          }
+          grid[row * side + column] = glm::normalize(normal + a * tangent + b * bitangent);
+        }
+      }
+      for (std::size_t row = 0; row < subdivisions; ++row) {
+        for (std::size_t column = 0; column < subdivisions; ++column) {
+          std::size_t quad[4] = {row * side + column, row * side + column + 1, (row + 1) * side + column + 1, (row + 1) * side + column};
+          // two triangles sharing the diagonal from the first to the third corner
+          std::size_t const halves[2][3] = {{quad[0], quad[1], quad[2]}, {quad[0], quad[2], quad[3]}};
+          for (auto const& half : halves) {
+            sphere_corner corners[3];
+            for (unsigned i = 0; i < 3; ++i) {
+              corners[i].direction = grid[half[i]];
+            }
+            // counter clockwise seen from outside
+            glm::fvec3 face_normal = glm::cross(corners[1].direction - corners[0].direction, corners[2].direction - corners[0].direction);
+            if (glm::dot(face_normal, corners[0].direction + corners[1].direction + corners[2].direction) < 0.0f) {
+              std::swap(corners[1], corners[2]);
+            }
+            if (has_uvs) {
+              sphere_texcoords(corners);
+            }
+            for (sphere_corner const& corner : corners) {
+              emit(corner);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  model result{vertex_data, attributes, triangles};
+  model_loader::compute_bounds(result);
+  return result;
+}
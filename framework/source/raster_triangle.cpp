@@ -0,0 +1,53 @@
+#include "raster_triangle.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// triangles with less screen area cover no pixel center worth rasterizing
+const float MIN_TRIANGLE_AREA = 1e-8f;
+
+bool setup_raster_triangle(glm::fvec3 const (&corners)[3], std::size_t width, std::size_t height,
+                           raster_triangle& result, int (&order)[3], float& area) {
+  area = (corners[1].x - corners[0].x) * (corners[2].y - corners[0].y) - (corners[1].y - corners[0].y) * (corners[2].x - corners[0].x);
+  if (std::abs(area) < MIN_TRIANGLE_AREA) {
+    return false;
+  }
+  order[0] = 0;
+  order[1] = 1;
+  order[2] = 2;
+  if (area < 0.0f) {
+    std::swap(order[1], order[2]);
+    area = -area;
+  }
+  glm::fvec3 const& p0 = corners[order[0]];
+  glm::fvec3 const& p1 = corners[order[1]];
+  glm::fvec3 const& p2 = corners[order[2]];
+
+  // pixel centers are at half coordinates, clamped before conversion as vertices near the camera project far outside
+  result.min_x = int(std::floor(std::max(std::min({p0.x, p1.x, p2.x}) - 0.5f, 0.0f)));
+  result.max_x = int(std::ceil(std::min(std::max({p0.x, p1.x, p2.x}) - 0.5f, float(width - 1))));
+  result.min_y = int(std::floor(std::max(std::min({p0.y, p1.y, p2.y}) - 0.5f, 0.0f)));
+  result.max_y = int(std::ceil(std::min(std::max({p0.y, p1.y, p2.y}) - 0.5f, float(height - 1))));
+  if (result.min_x > result.max_x || result.min_y > result.max_y) {
+    return false;
+  }
+  // edge opposite of each vertex, positive inside
+  glm::fvec3 const* ordered[3] = {&p0, &p1, &p2};
+  for (int edge = 0; edge < 3; ++edge) {
+    glm::fvec3 const& from = *ordered[(edge + 1) % 3];
+    glm::fvec3 const& to = *ordered[(edge + 2) % 3];
+    result.edge_dx[edge] = from.y - to.y;
+    result.edge_dy[edge] = to.x - from.x;
+    result.edge_c[edge] = from.x * to.y - from.y * to.x;
+  }
+  // depth is affine in screen space after the perspective division
+  result.depth = raster_plane(p0, p1, p2, area, p0.z, p1.z, p2.z);
+  return true;
+}
+
+glm::fvec3 raster_plane(glm::fvec3 const& p0, glm::fvec3 const& p1, glm::fvec3 const& p2, float area,
+                        float f0, float f1, float f2) {
+  float dx = ((f1 - f0) * (p2.y - p0.y) - (f2 - f0) * (p1.y - p0.y)) / area;
+  float dy = ((f2 - f0) * (p1.x - p0.x) - (f1 - f0) * (p2.x - p0.x)) / area;
+  return glm::fvec3{f0 - dx * p0.x - dy * p0.y, dx, dy};
+}
@@ -0,0 +1,100 @@
+#include "rect_packer.hpp"
+
+#include <algorithm>
+
+rect_packer::rect_packer(std::size_t width, std::size_t height)
+ :m_width{width}
+ ,m_height{height}
+ ,m_used_area{0}
+ ,m_skyline{}
+{
+  clear();
+}
+
+bool rect_packer::insert(std::size_t width, std::size_t height, std::size_t& x, std::size_t& y) {
+  // lowest top edge wins, ties go to the narrower segment to keep wide ones for wide rectangles
+  std::size_t best = m_skyline.size();
+  std::size_t best_top = 0;
+  std::size_t best_width = 0;
+  for (std::size_t i = 0; i < m_skyline.size(); ++i) {
+    std::size_t top = 0;
+    if (!fit(i, width, height, top)) {
+      continue;
+    }
+    top += height;
+    if (best == m_skyline.size() || top < best_top || (top == best_top && m_skyline[i].width < best_width)) {
+      best = i;
+      best_top = top;
+      best_width = m_skyline[i].width;
+    }
+  }
+  if (best == m_skyline.size()) {
+    return false;
+  }
+  x = m_skyline[best].x;
+  y = best_top - height;
+
+  // the new segment replaces the covered part of the skyline
+  m_skyline.insert(m_skyline.begin() + std::ptrdiff_t(best), segment{x, best_top, width});
+  std::size_t right = x + width;
+  std::size_t next = best + 1;
+  while (next < m_skyline.size() && m_skyline[next].x < right) {
+    std::size_t end = m_skyline[next].x + m_skyline[next].width;
+    if (end <= right) {
+      m_skyline.erase(m_skyline.begin() + std::ptrdiff_t(next));
+    }
+    else {
+      m_skyline[next].width = end - right;
+      m_skyline[next].x = right;
+      break;
+    }
+  }
+  // neighbours of equal height become one segment
+  for (std::size_t i = 0; i + 1 < m_skyline.size();) {
+    if (m_skyline[i].y == m_skyline[i + 1].y) {
+      m_skyline[i].width += m_skyline[i + 1].width;
+      m_skyline.erase(m_skyline.begin() + std::ptrdiff_t(i + 1));
+    }
+    else {
+      ++i;
+    }
+  }
+  m_used_area += width * height;
+  return true;
+}
+
+bool rect_packer::fit(std::size_t index, std::size_t width, std::size_t height, std::size_t& y) const {
+  std::size_t x = m_skyline[index].x;
+  if (x + width > m_width) {
+    return false;
+  }
+  // rectangle rests on the highest segment below it
+  y = 0;
+  std::size_t remaining = width;
+  for (std::size_t i = index; remaining > 0; ++i) {
+    y = std::max(y, m_skyline[i].y);
+    if (y + height > m_height) {
+      return false;
+    }
+    remaining -= std::min(remaining, m_skyline[i].width);
+  }
+  return true;
+}
+
+void rect_packer::clear() {
+  m_skyline.assign(1, segment{0, 0, m_width});
+  m_used_area = 0;
+}
+
+std::size_t rect_packer::width() const {
+  return m_width;
+}
+
+std::size_t rect_packer::height() const {
+  return m_height;
+}
+
+float rect_packer::occupancy() const {
+  std::size_t area = m_width * m_height;
+  return area > 0 ? float(m_used_area) / float(area) : 0.0f;
+}
@@ -0,0 +1,92 @@
+#include "scene_graph.hpp"
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+// no node is dirty
+static const std::size_t CLEAN = std::numeric_limits<std::size_t>::max();
+
+scene_graph::scene_graph()
+ :m_parents{}
+ ,m_locals{}
+ ,m_worlds{}
+ ,m_normals{}
+ ,m_dirty{}
+ ,m_updated{}
+ ,m_pass{0}
+ ,m_first_dirty{CLEAN}
+{}
+
+std::size_t scene_graph::add_node(int parent, glm::fmat4 const& local) {
+  // appending keeps the array topologically sorted
+  if (parent != NO_PARENT && (parent < 0 || std::size_t(parent) >= size())) {
+    throw std::out_of_range("scene_graph: parent " + std::to_string(parent) + " does not exist");
+  }
+  std::size_t node = size();
+  m_parents.push_back(parent);
+  m_locals.push_back(local);
+  m_worlds.push_back(glm::fmat4{});
+  m_normals.push_back(glm::fmat4{});
+  m_dirty.push_back(1);
+  m_updated.push_back(0);
+  m_first_dirty = std::min(m_first_dirty, node);
+  return node;
+}
+
+void scene_graph::set_local(std::size_t node, glm::fmat4 const& local) {
+  m_locals[node] = local;
+  m_dirty[node] = 1;
+  m_first_dirty = std::min(m_first_dirty, node);
+}
+
+std::size_t scene_graph::update() {
+  if (m_first_dirty == CLEAN) {
+    return 0;
+  }
+  ++m_pass;
+  std::size_t updated = 0;
+  for (std::size_t node = m_first_dirty; node < size(); ++node) {
+    int parent = m_parents[node];
+    // parents are processed first, so their world matrix is already current
+    bool parent_changed = parent != NO_PARENT && m_updated[parent] == m_pass;
+    if (!m_dirty[node] && !parent_changed) {
+      continue;
+    }
+    if (parent == NO_PARENT) {
+      m_worlds[node] = m_locals[node];
+    }
+    else {
+      m_worlds[node] = m_worlds[parent] * m_locals[node];
+    }
+    m_normals[node] = glm::inverseTranspose(m_worlds[node]);
+    m_dirty[node] = 0;
+    m_updated[node] = m_pass;
+    ++updated;
+  }
+  m_first_dirty = CLEAN;
+  return updated;
+}
+
+int scene_graph::parent(std::size_t node) const {
+  return m_parents[node];
+}
+
+glm::fmat4 const& scene_graph::local(std::size_t node) const {
+  return m_locals[node];
+}
+
+glm::fmat4 const& scene_graph::world(std::size_t node) const {
+  return m_worlds[node];
+}
+
+glm::fmat4 const& scene_graph::normal(std::size_t node) const {
+  return m_normals[node];
+}
+
+std::size_t scene_graph::size() const {
+  return m_parents.size();
+}
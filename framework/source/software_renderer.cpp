@@ -0,0 +1,444 @@
+#include "software_renderer.hpp"
+#include "job_system.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define SOFTWARE_RENDERER_SSE
+  #include <emmintrin.h>
+#endif
+
+// tiles are the unit of parallel rasterization, small enough to balance, large enough to bin few triangles twice
+const std::size_t TILE_SIZE = 32;
+const std::size_t MIN_VERTICES_PER_JOB = 4096;
+const std::size_t MIN_TRIANGLES_PER_JOB = 1024;
+
+#ifndef SOFTWARE_RENDERER_SSE
+// unlit color of simple.frag, rgba with red in the lowest byte, the sse path packs four pixels inline
+static std::uint32_t pack_normal_color(glm::fvec3 const& normal) {
+  glm::fvec3 color = glm::abs(normal / std::sqrt(std::max(glm::dot(normal, normal), 1e-30f)));
+  std::uint32_t r = std::uint32_t(std::min(color.x * 255.0f + 0.5f, 255.0f));
+  std::uint32_t g = std::uint32_t(std::min(color.y * 255.0f + 0.5f, 255.0f));
+  std::uint32_t b = std::uint32_t(std::min(color.z * 255.0f + 0.5f, 255.0f));
+  return r | (g << 8) | (b << 16) | 0xff000000u;
+}
+#endif
+
+software_renderer::software_renderer(std::size_t width, std::size_t height)
+ :m_width{std::max(width, std::size_t(1))}
+ ,m_height{std::max(height, std::size_t(1))}
+ ,m_stride{(m_width + 3) / 4 * 4}
+ ,m_tiles_x{(m_width + TILE_SIZE - 1) / TILE_SIZE}
+ ,m_tiles_y{(m_height + TILE_SIZE - 1) / TILE_SIZE}
+ ,m_view{}
+ ,m_projection{}
+ ,m_color(m_stride * m_height, 0)
+ ,m_depth(m_stride * m_height, 1.0f)
+ ,m_draws{}
+ ,m_vertices{}
+ ,m_chunks{}
+ ,m_chunk_count{0}
+{}
+
+void software_renderer::set_camera(glm::fmat4 const& view_matrix, glm::fmat4 const& projection_matrix) {
+  m_view = view_matrix;
+  m_projection = projection_matrix;
+}
+
+void software_renderer::clear(glm::fvec4 const& color) {
+  glm::fvec4 clamped = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+  std::uint32_t packed = std::uint32_t(clamped.r) | (std::uint32_t(clamped.g) << 8) | (std::uint32_t(clamped.b) << 16) | (std::uint32_t(clamped.a) << 24);
+  std::fill(m_color.begin(), m_color.end(), packed);
+  std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+}
+
+void software_renderer::draw(model const& mesh, glm::fmat4 const& model_matrix, glm::fmat4 const& normal_matrix) {
+  std::size_t first_vertex = m_draws.empty() ? 0 : m_draws.back().first_vertex + m_draws.back().mesh->vertex_num;
+  m_draws.push_back(draw_call{&mesh, m_projection * m_view * model_matrix, m_view * normal_matrix, first_vertex});
+}
+
+void software_renderer::finish(unsigned threads) {
+  if (m_draws.empty()) {
+    return;
+  }
+  if (threads == 0) {
+    threads = job_system::instance().concurrency();
+  }
+
+  // vertex stage, jobs never span two draws
+  struct vertex_range {
+    std::size_t draw;
+    std::size_t first;
+    std::size_t last;
+  };
+  std::vector<vertex_range> vertex_jobs{};
+  m_chunk_count = 0;
+  for (std::size_t d = 0; d < m_draws.size(); ++d) {
+    model const& mesh = *m_draws[d].mesh;
+    std::size_t vertex_grain = std::max(MIN_VERTICES_PER_JOB, (mesh.vertex_num + threads - 1) / threads);
+    for (std::size_t first = 0; first < mesh.vertex_num; first += vertex_grain) {
+      vertex_jobs.push_back(vertex_range{d, first, std::min(first + vertex_grain, mesh.vertex_num)});
+    }
+    std::size_t triangles = (mesh.indices.empty() ? mesh.vertex_num : mesh.indices.size()) / 3;
+    std::size_t triangle_grain = std::max(MIN_TRIANGLES_PER_JOB, (triangles + threads - 1) / threads);
+    for (std::size_t first = 0; first < triangles; first += triangle_grain) {
+      if (m_chunk_count == m_chunks.size()) {
+        m_chunks.emplace_back();
+      }
+      chunk& target = m_chunks[m_chunk_count++];
+      target.draw = d;
+      target.first_triangle = first;
+      target.last_triangle = std::min(first + triangle_grain, triangles);
+    }
+  }
+  m_vertices.resize(m_draws.back().first_vertex + m_draws.back().mesh->vertex_num);
+  // every draw makes at least one job, so the jobs are grouped to stay within the thread limit
+  std::size_t vertex_job_grain = (vertex_jobs.size() + threads - 1) / threads;
+  parallel_for(0, vertex_jobs.size(), vertex_job_grain, [&](std::size_t first, std::size_t last) {
+    for (std::size_t job = first; job < last; ++job) {
+      transform_vertices(m_draws[vertex_jobs[job].draw], vertex_jobs[job].first, vertex_jobs[job].last);
+    }
+  });
+
+  // setup and binning
+  std::size_t chunk_grain = (m_chunk_count + threads - 1) / threads;
+  parallel_for(0, m_chunk_count, chunk_grain, [this](std::size_t first, std::size_t last) {
+    for (std::size_t c = first; c < last; ++c) {
+      bin(m_chunks[c]);
+    }
+  });
+
+  // tiles own disjoint pixels, no synchronization needed
+  std::size_t tiles = m_tiles_x * m_tiles_y;
+  std::size_t tile_grain = (tiles + threads - 1) / threads;
+  parallel_for(0, tiles, tile_grain, [this](std::size_t first, std::size_t last) {
+    for (std::size_t tile = first; tile < last; ++tile) {
+      rasterize_tile(tile);
+    }
+  });
+  m_draws.clear();
+}
+
+void software_renderer::transform_vertices(draw_call const& call, std::size_t first, std::size_t last) {
+  model const& mesh = *call.mesh;
+  std::size_t stride = std::size_t(mesh.vertex_bytes) / sizeof(GLfloat);
+  std::size_t position_offset = mesh.offset(model::POSITION) / sizeof(GLfloat);
+  bool has_normal = (mesh.attributes & model::NORMAL) != 0;
+  std::size_t normal_offset = has_normal ? mesh.offset(model::NORMAL) / sizeof(GLfloat) : 0;
+  for (std::size_t i = first; i < last; ++i) {
+    float const* vertex = mesh.data.data() + i * stride;
+    float const* position = vertex + position_offset;
+    clip_vertex& result = m_vertices[call.first_vertex + i];
+    result.position = call.model_view_projection * glm::fvec4{position[0], position[1], position[2], 1.0f};
+    // models without normals face the camera
+    if (has_normal) {
+      float const* normal = vertex + normal_offset;
+      result.normal = glm::fvec3{call.view_normal * glm::fvec4{normal[0], normal[1], normal[2], 0.0f}};
+    }
+    else {
+      result.normal = glm::fvec3{0.0f, 0.0f, 1.0f};
+    }
+  }
+}
+
+void software_renderer::bin(chunk& target) const {
+  target.triangles.clear();
+  target.bins.resize(m_tiles_x * m_tiles_y);
+  for (auto& tile_bin : target.bins) {
+    tile_bin.clear();
+  }
+
+  draw_call const& call = m_draws[target.draw];
+  model const& mesh = *call.mesh;
+  clip_vertex const* vertices = m_vertices.data() + call.first_vertex;
+  for (std::size_t t = target.first_triangle; t < target.last_triangle; ++t) {
+    if (mesh.indices.empty()) {
+      add_triangle(target, vertices[t * 3], vertices[t * 3 + 1], vertices[t * 3 + 2]);
+    }
+    else {
+      add_triangle(target, vertices[mesh.indices[t * 3]], vertices[mesh.indices[t * 3 + 1]], vertices[mesh.indices[t * 3 + 2]]);
+    }
+  }
+
+  for (std::size_t i = 0; i < target.triangles.size(); ++i) {
+    triangle const& tri = target.triangles[i];
+    std::size_t first_x = std::size_t(tri.min_x) / TILE_SIZE;
+    std::size_t last_x = std::size_t(tri.max_x) / TILE_SIZE;
+    std::size_t first_y = std::size_t(tri.min_y) / TILE_SIZE;
+    std::size_t last_y = std::size_t(tri.max_y) / TILE_SIZE;
+    for (std::size_t y = first_y; y <= last_y; ++y) {
+      for (std::size_t x = first_x; x <= last_x; ++x) {
+        target.bins[y * m_tiles_x + x].push_back(std::uint32_t(i));
+      }
+    }
+  }
+}
+
+void software_renderer::add_triangle(chunk& target, clip_vertex const& a, clip_vertex const& b, clip_vertex const& c) const {
+  clip_vertex const* input[3] = {&a, &b, &c};
+  // signed distance to the near plane, z >= -w is inside
+  float distance[3];
+  int inside = 0;
+  for (int i = 0; i < 3; ++i) {
+    distance[i] = input[i]->position.z + input[i]->position.w;
+    inside += distance[i] >= 0.0f;
+  }
+  if (inside == 3) {
+    setup_triangle(target, a, b, c);
+    return;
+  }
+  if (inside == 0) {
+    return;
+  }
+  // clip polygon has at most four vertices
+  clip_vertex polygon[4];
+  int count = 0;
+  for (int i = 0; i < 3; ++i) {
+    int next = (i + 1) % 3;
+    if (distance[i] >= 0.0f) {
+      polygon[count++] = *input[i];
+    }
+    if ((distance[i] >= 0.0f) != (distance[next] >= 0.0f)) {
+      float t = distance[i] / (distance[i] - distance[next]);
+      polygon[count].position = glm::mix(input[i]->position, input[next]->position, t);
+      polygon[count].normal = glm::mix(input[i]->normal, input[next]->normal, t);
+      ++count;
+    }
+  }
+  for (int i = 1; i + 1 < count; ++i) {
+    setup_triangle(target, polygon[0], polygon[i], polygon[i + 1]);
+  }
+}
+
+void software_renderer::setup_triangle(chunk& target, clip_vertex const& a, clip_vertex const& b, clip_vertex const& c) const {
+  clip_vertex const* input[3] = {&a, &b, &c};
+  glm::fvec3 screen[3];
+  float inverse_w[3];
+  for (int i = 0; i < 3; ++i) {
+    glm::fvec4 const& clip = input[i]->position;
+    // vertices on the near plane of an orthographic projection may have w close to zero
+    if (clip.w <= 0.0f) {
+      return;
+    }
+    inverse_w[i] = 1.0f / clip.w;
+    screen[i] = glm::fvec3{(clip.x * inverse_w[i] * 0.5f + 0.5f) * float(m_width),
+                           (0.5f - clip.y * inverse_w[i] * 0.5f) * float(m_height),
+                           clip.z * inverse_w[i] * 0.5f + 0.5f};
+  }
+  // face culling is disabled in the gl pipeline, both windings are drawn
+  triangle tri{};
+  int order[3];
+  float area;
+  if (!setup_raster_triangle(screen, m_width, m_height, tri, order, area)) {
+    return;
+  }
+  glm::fvec3 const& p0 = screen[order[0]];
+  glm::fvec3 const& p1 = screen[order[1]];
+  glm::fvec3 const& p2 = screen[order[2]];
+  // 1 / w is affine in screen space like depth, attributes only after division by w
+  tri.inverse_w = raster_plane(p0, p1, p2, area, inverse_w[order[0]], inverse_w[order[1]], inverse_w[order[2]]);
+  for (int component = 0; component < 3; ++component) {
+    tri.normal[component] = raster_plane(p0, p1, p2, area,
+                                         input[order[0]]->normal[component] * inverse_w[order[0]],
+                                         input[order[1]]->normal[component] * inverse_w[order[1]],
+                                         input[order[2]]->normal[component] * inverse_w[order[2]]);
+  }
+  target.triangles.push_back(tri);
+}
+
+void software_renderer::rasterize_tile(std::size_t tile) {
+  int tile_min_x = int((tile % m_tiles_x) * TILE_SIZE);
+  int tile_min_y = int((tile / m_tiles_x) * TILE_SIZE);
+  int tile_max_x = std::min(tile_min_x + int(TILE_SIZE), int(m_width)) - 1;
+  int tile_max_y = std::min(tile_min_y + int(TILE_SIZE), int(m_height)) - 1;
+
+  for (std::size_t c = 0; c < m_chunk_count; ++c) {
+    chunk const& source = m_chunks[c];
+    for (std::uint32_t index : source.bins[tile]) {
+      triangle const& tri = source.triangles[index];
+      // whole blocks of four pixels, the stride is a multiple of four and tiles start at multiples of four
+      int min_x = std::max(tri.min_x, tile_min_x) & ~3;
+      int max_x = std::min(tri.max_x, tile_max_x);
+      int min_y = std::max(tri.min_y, tile_min_y);
+      int max_y = std::min(tri.max_y, tile_max_y);
+
+#ifdef SOFTWARE_RENDERER_SSE
+      __m128 const zero = _mm_setzero_ps();
+      __m128 const start_x = _mm_add_ps(_mm_set1_ps(float(min_x)), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+      __m128 const channel_max = _mm_set1_ps(255.0f);
+      __m128 const half = _mm_set1_ps(0.5f);
+      __m128i const alpha = _mm_set1_epi32(int(0xff000000u));
+      __m128 const abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+      __m128 edge_step[3];
+      for (int edge = 0; edge < 3; ++edge) {
+        edge_step[edge] = _mm_set1_ps(tri.edge_dx[edge] * 4.0f);
+      }
+      __m128 depth_step = _mm_set1_ps(tri.depth.y * 4.0f);
+
+      for (int y = min_y; y <= max_y; ++y) {
+        float center_y = float(y) + 0.5f;
+        __m128 edge_value[3];
+        for (int edge = 0; edge < 3; ++edge) {
+          edge_value[edge] = _mm_add_ps(_mm_mul_ps(start_x, _mm_set1_ps(tri.edge_dx[edge])),
+                                        _mm_set1_ps(tri.edge_c[edge] + tri.edge_dy[edge] * center_y));
+        }
+        __m128 depth_value = _mm_add_ps(_mm_mul_ps(start_x, _mm_set1_ps(tri.depth.y)),
+                                        _mm_set1_ps(tri.depth.x + tri.depth.z * center_y));
+        float* depth_row = m_depth.data() + std::size_t(y) * m_stride;
+        std::uint32_t* color_row = m_color.data() + std::size_t(y) * m_stride;
+
+        for (int x = min_x; x <= max_x; x += 4) {
+          __m128 previous_depth = _mm_loadu_ps(depth_row + x);
+          __m128 pass = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge_value[0], zero), _mm_cmpge_ps(edge_value[1], zero)),
+                                   _mm_and_ps(_mm_cmpge_ps(edge_value[2], zero), _mm_cmplt_ps(depth_value, previous_depth)));
+          if (_mm_movemask_ps(pass)) {
+            __m128 pixel_x = _mm_add_ps(_mm_set1_ps(float(x)), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+            __m128 pixel_y = _mm_set1_ps(center_y);
+            // perspective correct normal
+            __m128 w = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_set1_ps(tri.inverse_w.x),
+                                  _mm_add_ps(_mm_mul_ps(pixel_x, _mm_set1_ps(tri.inverse_w.y)), _mm_mul_ps(pixel_y, _mm_set1_ps(tri.inverse_w.z)))));
+            __m128 normal[3];
+            for (int component = 0; component < 3; ++component) {
+              glm::fvec3 const& plane = tri.normal[component];
+              normal[component] = _mm_mul_ps(w, _mm_add_ps(_mm_set1_ps(plane.x),
+                                             _mm_add_ps(_mm_mul_ps(pixel_x, _mm_set1_ps(plane.y)), _mm_mul_ps(pixel_y, _mm_set1_ps(plane.z)))));
+            }
+            __m128 length_squared = _mm_add_ps(_mm_mul_ps(normal[0], normal[0]), _mm_add_ps(_mm_mul_ps(normal[1], normal[1]), _mm_mul_ps(normal[2], normal[2])));
+            __m128 scale = _mm_div_ps(channel_max, _mm_sqrt_ps(_mm_max_ps(length_squared, _mm_set1_ps(1e-30f))));
+            __m128i packed = alpha;
+            for (int component = 0; component < 3; ++component) {
+              __m128 channel = _mm_min_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(normal[component], abs_mask), scale), half), channel_max);
+              packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvttps_epi32(channel), component * 8));
+            }
+
+            __m128i previous_color = _mm_loadu_si128(reinterpret_cast<__m128i const*>(color_row + x));
+            __m128i pass_bits = _mm_castps_si128(pass);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(color_row + x),
+                             _mm_or_si128(_mm_and_si128(pass_bits, packed), _mm_andnot_si128(pass_bits, previous_color)));
+            _mm_storeu_ps(depth_row + x, _mm_or_ps(_mm_and_ps(pass, depth_value), _mm_andnot_ps(pass, previous_depth)));
+          }
+          for (int edge = 0; edge < 3; ++edge) {
+            edge_value[edge] = _mm_add_ps(edge_value[edge], edge_step[edge]);
+          }
+          depth_value = _mm_add_ps(depth_value, depth_step);
+        }
+      }
+#else
+      for (int y = min_y; y <= max_y; ++y) {
+        float center_y = float(y) + 0.5f;
+        float* depth_row = m_depth.data() + std::size_t(y) * m_stride;
+        std::uint32_t* color_row = m_color.data() + std::size_t(y) * m_stride;
+        for (int x = min_x; x <= max_x; ++x) {
+          float center_x = float(x) + 0.5f;
+          bool inside = true;
+          for (int edge = 0; edge < 3; ++edge) {
+            inside = inside && tri.edge_c[edge] + tri.edge_dx[edge] * center_x + tri.edge_dy[edge] * center_y >= 0.0f;
+          }
+          float depth = tri.depth.x + tri.depth.y * center_x + tri.depth.z * center_y;
+          if (inside && depth < depth_row[x]) {
+            float w = 1.0f / (tri.inverse_w.x + tri.inverse_w.y * center_x + tri.inverse_w.z * center_y);
+            glm::fvec3 normal{};
+            for (int component = 0; component < 3; ++component) {
+              glm::fvec3 const& plane = tri.normal[component];
+              normal[component] = (plane.x + plane.y * center_x + plane.z * center_y) * w;
+            }
+            depth_row[x] = depth;
+            color_row[x] = pack_normal_color(normal);
+          }
+        }
+      }
+#endif
+    }
+  }
+}
+
+pixel_data software_renderer::image() const {
+  std::vector<std::uint8_t> pixels(m_width * m_height * 4);
+  for (std::size_t y = 0; y < m_height; ++y) {
+    for (std::size_t x = 0; x < m_width; ++x) {
+      std::uint32_t color = m_color[y * m_stride + x];
+      std::uint8_t* pixel = &pixels[(y * m_width + x) * 4];
+      pixel[0] = std::uint8_t(color);
+      pixel[1] = std::uint8_t(color >> 8);
+      pixel[2] = std::uint8_t(color >> 16);
+      pixel[3] = std::uint8_t(color >> 24);
+    }
+  }
+  return pixel_data{pixels, GL_RGBA, GL_UNSIGNED_BYTE, m_width, m_height};
+}
+
+std::vector<float> const& software_renderer::depth() const {
+  return m_depth;
+}
+
+std::size_t software_renderer::width() const {
+  return m_width;
+}
+
+std::size_t software_renderer::height() const {
+  return m_height;
+}
+
+std::size_t software_renderer::triangle_count() const {
+  std::size_t count = 0;
+  for (std::size_t c = 0; c < m_chunk_count; ++c) {
+    count += m_chunks[c].triangles.size();
+  }
+  return count;
+}
+
+void write_tga(std::string const& file_name, pixel_data const& image) {
+  if (image.channels != GL_RGBA || image.channel_type != GL_UNSIGNED_BYTE) {
+    throw std::invalid_argument("Only GL_RGBA byte images can be written as tga");
+  }
+  std::ofstream file{file_name, std::ios::binary};
+  if (!file) {
+    throw std::runtime_error("Could not open " + file_name + " for writing");
+  }
+  unsigned char header[18] = {};
+  // uncompressed true color
+  header[2] = 2;
+  header[12] = std::uint8_t(image.width);
+  header[13] = std::uint8_t(image.width >> 8);
+  header[14] = std::uint8_t(image.height);
+  header[15] = std::uint8_t(image.height >> 8);
+  header[16] = 32;
+  // eight alpha bits, first row is the top
+  header[17] = 0x28;
+  file.write(reinterpret_cast<char const*>(header), sizeof(header));
+  // tga stores blue, green, red, alpha
+  std::vector<std::uint8_t> pixels(image.pixels.size());
+  for (std::size_t i = 0; i + 3 < pixels.size(); i += 4) {
+    pixels[i] = image.pixels[i + 2];
+    pixels[i + 1] = image.pixels[i + 1];
+    pixels[i + 2] = image.pixels[i];
+    pixels[i + 3] = image.pixels[i + 3];
+  }
+  file.write(reinterpret_cast<char const*>(pixels.data()), std::streamsize(pixels.size()));
+}
+
+image_difference compare_images(pixel_data const& result, pixel_data const& reference, unsigned tolerance) {
+  if (result.channels != GL_RGBA || reference.channels != GL_RGBA || result.width != reference.width || result.height != reference.height) {
+    throw std::invalid_argument("Compared images must both be GL_RGBA with equal size");
+  }
+  image_difference difference{0, 0, 0.0};
+  std::size_t pixel_count = result.width * result.height;
+  double total = 0.0;
+  for (std::size_t pixel = 0; pixel < pixel_count; ++pixel) {
+    unsigned pixel_max = 0;
+    for (std::size_t channel = 0; channel < 4; ++channel) {
+      unsigned channel_difference = unsigned(std::abs(int(result.pixels[pixel * 4 + channel]) - int(reference.pixels[pixel * 4 + channel])));
+      pixel_max = std::max(pixel_max, channel_difference);
+      total += double(channel_difference);
+    }
+    difference.max_difference = std::max(difference.max_difference, pixel_max);
+    difference.differing_pixels += pixel_max > tolerance;
+  }
+  difference.mean_difference = pixel_count > 0 ? total / double(pixel_count * 4) : 0.0;
+  return difference;
+}
@@ -0,0 +1,182 @@
+#include "star_field.hpp"
+#include "job_system.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define STAR_FIELD_SSE
+  #include <emmintrin.h>
+#endif
+
+// random numbers drawn per star: x, y, z and one for colour and magnitude,
+// the colour uses the lowest byte and the magnitude the highest
+const std::uint32_t STAR_COMPONENTS = 4;
+// below this many stars per job, scheduling is slower than generating
+const std::size_t MIN_STARS_PER_JOB = 65536;
+
+// bijective 32 bit integer mixing function with low bias
+static std::uint32_t mix(std::uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+// hash with precomputed key of the seed
+static std::uint32_t keyed_hash(std::uint32_t key, std::uint32_t counter) {
+  return mix(mix(counter ^ key) + key);
+}
+
+std::uint32_t random_hash(std::uint32_t seed, std::uint32_t counter) {
+  return keyed_hash(mix(seed), counter);
+}
+
+float random_unit(std::uint32_t seed, std::uint32_t counter) {
+  // upper 24 bits are exactly representable as float
+  return float(random_hash(seed, counter) >> 8) * (1.0f / 16777216.0f);
+}
+
+// colours by temperature and brightness by magnitude, indexed by bytes of a random number
+struct star_tables {
+  star_tables() {
+    // approximate colours of black bodies from red dwarfs to blue giants
+    const float keys[][3] = {
+      {1.00f, 0.70f, 0.45f},
+      {1.00f, 0.85f, 0.70f},
+      {1.00f, 0.95f, 0.90f},
+      {0.95f, 0.95f, 1.00f},
+      {0.75f, 0.82f, 1.00f}
+    };
+    const std::size_t key_num = sizeof(keys) / sizeof(keys[0]);
+    for (std::size_t i = 0; i < 256; ++i) {
+      // cool stars are more common than hot ones
+      float temperature = float(i) / 255.0f;
+      temperature *= temperature;
+      float position = temperature * float(key_num - 1);
+      std::size_t key = std::min(std::size_t(position), key_num - 2);
+      float fraction = position - float(key);
+      std::uint32_t color = 0;
+      for (std::size_t c = 0; c < 3; ++c) {
+        float value = keys[key][c] * (1.0f - fraction) + keys[key + 1][c] * fraction;
+        color |= std::uint32_t(value * 255.0f + 0.5f) << (c * 8);
+      }
+      colors[i] = color;
+    }
+
+    // number of stars brighter than a magnitude grows by roughly 10^(0.6 m),
+    // invert that distribution for uniform random numbers
+    const float brightest = -1.5f;
+    const float faintest = 6.5f;
+    for (std::size_t i = 0; i < 256; ++i) {
+      float uniform = (float(i) + 0.5f) / 256.0f;
+      float magnitude = std::max(brightest, faintest + std::log10(uniform) / 0.6f);
+      // keep the faintest stars visible
+      float brightness = 1.0f - 0.85f * (magnitude - brightest) / (faintest - brightest);
+      alphas[i] = std::uint32_t(brightness * 255.0f + 0.5f) << 24;
+    }
+  }
+
+  std::uint32_t colors[256];
+  std::uint32_t alphas[256];
+};
+
+static star_tables const& star_lookup() {
+  static star_tables const instance{};
+  return instance;
+}
+
+static std::uint32_t star_color(star_tables const& lookup, std::uint32_t random) {
+  return lookup.colors[random & 0xff] | lookup.alphas[random >> 24];
+}
+
+#ifdef STAR_FIELD_SSE
+// sse2 has no 32 bit low multiplication, combine the even and odd lanes
+static __m128i multiply(__m128i a, __m128i b) {
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static __m128i mix(__m128i x) {
+  x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+  x = multiply(x, _mm_set1_epi32(0x7feb352d));
+  x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+  x = multiply(x, _mm_set1_epi32(int(0x846ca68bu)));
+  x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+  return x;
+}
+
+static __m128i keyed_hash(__m128i key, __m128i counter) {
+  return mix(_mm_add_epi32(mix(_mm_xor_si128(counter, key)), key));
+}
+
+// coordinate in [-extent, extent) from a random number
+static __m128 coordinate(__m128i random, __m128 extent) {
+  __m128 unit = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(random, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+  return _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(unit, _mm_set1_ps(2.0f)), _mm_set1_ps(1.0f)), extent);
+}
+#endif
+
+static float coordinate(std::uint32_t random, float extent) {
+  float unit = float(random >> 8) * (1.0f / 16777216.0f);
+  return (unit * 2.0f - 1.0f) * extent;
+}
+
+void generate_stars(std::uint32_t seed, std::size_t first, std::size_t count, float extent, star_point* stars) {
+  star_tables const& lookup = star_lookup();
+  std::uint32_t key = mix(seed);
+  std::size_t i = 0;
+#ifdef STAR_FIELD_SSE
+  // four stars at once, each component of them in one register
+  __m128i key4 = _mm_set1_epi32(int(key));
+  __m128 extent4 = _mm_set1_ps(extent);
+  __m128i lane_offsets = _mm_setr_epi32(0, int(STAR_COMPONENTS), int(STAR_COMPONENTS * 2), int(STAR_COMPONENTS * 3));
+  for (; i + 4 <= count; i += 4) {
+    __m128i counter = _mm_add_epi32(_mm_set1_epi32(int(std::uint32_t(first + i) * STAR_COMPONENTS)), lane_offsets);
+    __m128 x = coordinate(keyed_hash(key4, counter), extent4);
+    __m128 y = coordinate(keyed_hash(key4, _mm_add_epi32(counter, _mm_set1_epi32(1))), extent4);
+    __m128 z = coordinate(keyed_hash(key4, _mm_add_epi32(counter, _mm_set1_epi32(2))), extent4);
+
+    alignas(16) std::uint32_t random[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(random), keyed_hash(key4, _mm_add_epi32(counter, _mm_set1_epi32(3))));
+    for (std::uint32_t& color : random) {
+      color = star_color(lookup, color);
+    }
+    __m128 color = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<__m128i const*>(random)));
+
+    // components to interleaved points
+    _MM_TRANSPOSE4_PS(x, y, z, color);
+    float* target = reinterpret_cast<float*>(stars + i);
+    _mm_storeu_ps(target, x);
+    _mm_storeu_ps(target + 4, y);
+    _mm_storeu_ps(target + 8, z);
+    _mm_storeu_ps(target + 12, color);
+  }
+#endif
+  for (; i < count; ++i) {
+    std::uint32_t counter = std::uint32_t(first + i) * STAR_COMPONENTS;
+    star_point& star = stars[i];
+    star.x = coordinate(keyed_hash(key, counter), extent);
+    star.y = coordinate(keyed_hash(key, counter + 1), extent);
+    star.z = coordinate(keyed_hash(key, counter + 2), extent);
+    star.color = star_color(lookup, keyed_hash(key, counter + 3));
+  }
+}
+
+std::vector<star_point> generate_star_field(std::uint32_t seed, std::size_t count, float extent, unsigned threads) {
+  std::vector<star_point> stars(count);
+  if (threads == 0) {
+    threads = job_system::instance().concurrency();
+  }
+  // multiple of four, so only the last chunk has a scalar tail
+  std::size_t grain = std::max(MIN_STARS_PER_JOB, (count + threads - 1) / threads);
+  grain = (grain + 3) & ~std::size_t(3);
+  parallel_for(0, count, grain, [&](std::size_t first, std::size_t last) {
+    generate_stars(seed, first, last - first, extent, stars.data() + first);
+  });
+  return stars;
+}
@@ -0,0 +1,130 @@
+#include "stream_buffer.hpp"
+
+#include <glbinding/ContextInfo.h>
+#include <glbinding/Version.h>
+#include <glbinding/gl/extension.h>
+
+#include <stdexcept>
+#include <string>
+
+// uniform buffer offsets need the largest alignment, usually 256 bytes
+const std::size_t REGION_ALIGNMENT = 256;
+// one second, waiting on a region longer means the gpu is hung
+const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+// whether buffers can stay mapped while the gpu reads them
+static bool supports_buffer_storage() {
+  if (glbinding::ContextInfo::version() >= glbinding::Version(4, 4)) {
+    return true;
+  }
+  auto extensions = glbinding::ContextInfo::extensions();
+  return extensions.find(GLextension::GL_ARB_buffer_storage) != extensions.end();
+}
+
+stream_buffer::stream_buffer(GLenum target, std::size_t frame_size, unsigned frames)
+ :m_target{target}
+ ,m_handle{0}
+ ,m_frame_size{(frame_size + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT}
+ ,m_frames{frames}
+ ,m_persistent{supports_buffer_storage()}
+ ,m_mapping{nullptr}
+ ,m_region{0}
+ ,m_used{0}
+ ,m_fences(frames, nullptr)
+ ,m_asset{0}
+{
+  GLsizeiptr total_size = GLsizeiptr(m_frame_size * m_frames);
+  glGenBuffers(1, &m_handle);
+  glBindBuffer(m_target, m_handle);
+  if (m_persistent) {
+    // coherent mapping, writes become visible without explicit flushes
+    glBufferStorage(m_target, total_size, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    m_mapping = static_cast<unsigned char*>(glMapBufferRange(m_target, 0, total_size, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+    if (!m_mapping) {
+      throw std::runtime_error("Persistent mapping of stream buffer failed");
+    }
+  }
+  else {
+    glBufferData(m_target, total_size, nullptr, GL_STREAM_DRAW);
+  }
+  m_asset = asset_memory::instance().track("stream buffer", "buffer", 0, std::size_t(total_size));
+}
+
+stream_buffer::~stream_buffer() {
+  asset_memory::instance().untrack(m_asset);
+  for (GLsync fence : m_fences) {
+    if (fence) {
+      glDeleteSync(fence);
+    }
+  }
+  glBindBuffer(m_target, m_handle);
+  if (m_mapping) {
+    glUnmapBuffer(m_target);
+  }
+  glDeleteBuffers(1, &m_handle);
+}
+
+void stream_buffer::begin_frame() {
+  m_region = (m_region + 1) % m_frames;
+  m_used = 0;
+  GLsync& fence = m_fences[m_region];
+  if (fence) {
+    // flush on first wait, otherwise the fence may never be submitted
+    GLenum result = glClientWaitSync(fence, SyncObjectMask::GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+    while (result == GL_TIMEOUT_EXPIRED) {
+      result = glClientWaitSync(fence, SyncObjectMask::GL_NONE_BIT, FENCE_TIMEOUT);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+  if (!m_persistent) {
+    // the fence already guarantees the region is unused, no implicit synchronization needed
+    glBindBuffer(m_target, m_handle);
+    m_mapping = static_cast<unsigned char*>(glMapBufferRange(m_target, GLintptr(m_region * m_frame_size), GLsizeiptr(m_frame_size),
+                                                             GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+    if (!m_mapping) {
+      throw std::runtime_error("Mapping of stream buffer region failed");
+    }
+  }
+}
+
+stream_buffer::allocation stream_buffer::allocate(std::size_t size, std::size_t alignment) {
+  std::size_t start = (m_used + alignment - 1) / alignment * alignment;
+  if (start + size > m_frame_size) {
+    throw std::length_error("Stream buffer region of " + std::to_string(m_frame_size) + " bytes is full");
+  }
+  m_used = start + size;
+  std::size_t region_offset = m_region * m_frame_size;
+  unsigned char* region_data = m_persistent ? m_mapping + region_offset : m_mapping;
+  return allocation{region_data + start, GLintptr(region_offset + start), GLsizeiptr(size)};
+}
+
+void stream_buffer::end_writes() {
+  // draws must not source a buffer with a non persistent mapping
+  if (!m_persistent && m_mapping) {
+    glBindBuffer(m_target, m_handle);
+    glUnmapBuffer(m_target);
+    m_mapping = nullptr;
+  }
+}
+
+void stream_buffer::end_frame() {
+  end_writes();
+  m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, UnusedMask::GL_UNUSED_BIT);
+}
+
+GLuint stream_buffer::handle() const {
+  return m_handle;
+}
+
+GLenum stream_buffer::target() const {
+  return m_target;
+}
+
+bool stream_buffer::persistent() const {
+  return m_persistent;
+}
+
+std::size_t stream_buffer::used() const {
+  return m_used;
+}
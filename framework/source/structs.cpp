@@ -0,0 +1,57 @@
+#include "structs.hpp"
+
+void shader_program::set_uniform(std::string const& name, glm::fmat4 const& value) {
+  store_uniform(name, value, true);
+}
+
+void shader_program::set_uniform(std::string const& name, glm::fvec4 const& value) {
+  glm::fmat4 column{0.0f};
+  column[0] = value;
+  store_uniform(name, column, false);
+}
+
+void shader_program::store_uniform(std::string const& name, glm::fmat4 const& value, bool matrix) {
+  auto found = u_values.find(name);
+  if (found == u_values.end()) {
+    uniform_value& uniform = u_values[name];
+    auto location = u_locs.find(name);
+    uniform.location = location != u_locs.end() ? location->second : -1;
+    uniform.matrix = matrix;
+    uniform.value = value;
+    return;
+  }
+  uniform_value& uniform = found->second;
+  // setting an unchanged value every frame costs no upload
+  if (uniform.value != value || uniform.matrix != matrix) {
+    uniform.matrix = matrix;
+    uniform.value = value;
+    uniform.dirty = true;
+  }
+}
+
+void shader_program::invalidate_uniforms() {
+  for (auto& pair : u_values) {
+    auto location = u_locs.find(pair.first);
+    pair.second.location = location != u_locs.end() ? location->second : -1;
+    pair.second.dirty = true;
+  }
+}
+
+void shader_program::record_uniforms(command_buffer& commands) const {
+  for (auto const& pair : u_values) {
+    uniform_value const& uniform = pair.second;
+    if (!uniform.dirty) {
+      continue;
+    }
+    // uniforms removed by the compiler can not be set
+    if (uniform.location >= 0) {
+      if (uniform.matrix) {
+        commands.uniform(uniform.location, uniform.value);
+      }
+      else {
+        commands.uniform(uniform.location, uniform.value[0]);
+      }
+    }
+    uniform.dirty = false;
+  }
+}
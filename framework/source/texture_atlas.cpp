@@ -0,0 +1,206 @@
+#include "texture_atlas.hpp"
+#include "rect_packer.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// border of repeated edge texels around packed images, keeps filtering and the first mip levels from bleeding
+const std::size_t ATLAS_GUTTER = 4;
+// mip levels that stay inside the gutter, log2 of its size
+const GLint ATLAS_MAX_LEVEL = 2;
+
+static std::size_t align_to_gutter(std::size_t size) {
+  return (size + ATLAS_GUTTER - 1) / ATLAS_GUTTER * ATLAS_GUTTER;
+}
+
+texture_atlas::texture_atlas()
+ :m_images{}
+ ,m_surfaces{}
+ ,m_texture{}
+ ,m_layer_width{0}
+ ,m_layer_height{0}
+ ,m_layers{0}
+ ,m_atlas_occupancy{0.0f}
+ ,m_asset{asset_memory::instance().track("texture atlas", "texture")}
+{}
+
+texture_atlas::~texture_atlas() {
+  asset_memory::instance().untrack(m_asset);
+  glDeleteTextures(1, &m_texture.handle);
+}
+
+std::uint32_t texture_atlas::add(pixel_data image) {
+  m_images.push_back(std::move(image));
+  std::size_t queued_bytes = 0;
+  for (pixel_data const& queued : m_images) {
+    queued_bytes += queued.pixels.size();
+  }
+  asset_memory::instance().set_cpu_bytes(m_asset, queued_bytes);
+  return std::uint32_t(m_images.size() - 1);
+}
+
+void texture_atlas::build() {
+  for (pixel_data const& image : m_images) {
+    if (image.channels != GL_RGBA || image.channel_type != GL_UNSIGNED_BYTE || image.width == 0 || image.height == 0) {
+      throw std::invalid_argument("Texture atlas only holds GL_RGBA byte images");
+    }
+    m_layer_width = std::max(m_layer_width, image.width);
+    m_layer_height = std::max(m_layer_height, image.height);
+  }
+  m_surfaces.assign(m_images.size(), surface{glm::fvec2{0.0f}, glm::fvec2{1.0f}, 0.0f});
+  if (m_images.empty()) {
+    return;
+  }
+
+  // texel position of every image, full size ones come first
+  struct placement {
+    std::size_t layer;
+    std::size_t x;
+    std::size_t y;
+    std::size_t gutter;
+  };
+  std::vector<placement> placements(m_images.size());
+  std::vector<std::size_t> packed{};
+  m_layers = 0;
+  for (std::size_t i = 0; i < m_images.size(); ++i) {
+    if (m_images[i].width == m_layer_width && m_images[i].height == m_layer_height) {
+      placements[i] = placement{m_layers++, 0, 0, 0};
+    }
+    else {
+      packed.push_back(i);
+    }
+  }
+  // tall images first, the skyline stays flatter
+  std::sort(packed.begin(), packed.end(), [this](std::size_t a, std::size_t b) {
+    return m_images[a].height > m_images[b].height
+        || (m_images[a].height == m_images[b].height && m_images[a].width > m_images[b].width);
+  });
+  std::vector<rect_packer> pages{};
+  std::vector<std::size_t> page_layers{};
+  for (std::size_t i : packed) {
+    // gutter on both sides, sizes aligned so every rectangle starts on a multiple of the gutter
+    std::size_t width = align_to_gutter(m_images[i].width + 2 * ATLAS_GUTTER);
+    std::size_t height = align_to_gutter(m_images[i].height + 2 * ATLAS_GUTTER);
+    if (width > m_layer_width || height > m_layer_height) {
+      // nearly full size, no room for the gutter in a shared layer
+      placements[i] = placement{m_layers++, 0, 0, 0};
+      continue;
+    }
+    std::size_t x = 0;
+    std::size_t y = 0;
+    std::size_t page = 0;
+    while (page < pages.size() && !pages[page].insert(width, height, x, y)) {
+      ++page;
+    }
+    if (page == pages.size()) {
+      pages.push_back(rect_packer{m_layer_width, m_layer_height});
+      page_layers.push_back(m_layers++);
+      pages.back().insert(width, height, x, y);
+    }
+    placements[i] = placement{page_layers[page], x + ATLAS_GUTTER, y + ATLAS_GUTTER, ATLAS_GUTTER};
+  }
+  m_atlas_occupancy = 0.0f;
+  for (rect_packer const& page : pages) {
+    m_atlas_occupancy += page.occupancy() / float(pages.size());
+  }
+
+  // all layers are uploaded at once, texels outside of images stay transparent
+  std::size_t row_bytes = m_layer_width * 4;
+  std::size_t layer_bytes = row_bytes * m_layer_height;
+  std::vector<std::uint8_t> texels(layer_bytes * m_layers, 0);
+  for (std::size_t i = 0; i < m_images.size(); ++i) {
+    pixel_data const& image = m_images[i];
+    placement const& place = placements[i];
+    std::uint8_t* layer = texels.data() + place.layer * layer_bytes;
+    std::size_t gutter = place.gutter;
+    // gutter rows and columns repeat the nearest edge texel
+    for (std::size_t row = 0; row < image.height + 2 * gutter; ++row) {
+      std::size_t y = place.y + row - gutter;
+      std::size_t source_row = std::min(row >= gutter ? row - gutter : 0, image.height - 1);
+      std::uint8_t const* source = image.pixels.data() + source_row * image.width * 4;
+      std::uint8_t* target = layer + y * row_bytes + (place.x - gutter) * 4;
+      for (std::size_t column = 0; column < gutter; ++column) {
+        std::memcpy(target + column * 4, source, 4);
+        std::memcpy(target + (gutter + image.width + column) * 4, source + (image.width - 1) * 4, 4);
+      }
+      std::memcpy(target + gutter * 4, source, image.width * 4);
+    }
+
+    surface& entry = m_surfaces[i];
+    entry.offset = glm::fvec2{float(place.x) / float(m_layer_width), float(place.y) / float(m_layer_height)};
+    entry.scale = glm::fvec2{float(image.width) / float(m_layer_width), float(image.height) / float(m_layer_height)};
+    entry.layer = float(place.layer);
+  }
+
+  glDeleteTextures(1, &m_texture.handle);
+  m_texture.target = GL_TEXTURE_2D_ARRAY;
+  glGenTextures(1, &m_texture.handle);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture.handle);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, GLsizei(m_layer_width), GLsizei(m_layer_height), GLsizei(m_layers),
+               0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GLint(GL_CLAMP_TO_EDGE));
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GLint(GL_CLAMP_TO_EDGE));
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GLint(GL_LINEAR));
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GLint(GL_LINEAR_MIPMAP_LINEAR));
+  // default max level of gl, only limited by the 1x1 level
+  GLint max_level = 1000;
+  // coarser levels of shared layers would mix neighbouring images
+  if (!pages.empty()) {
+    max_level = ATLAS_MAX_LEVEL;
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, max_level);
+  }
+  glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+  // mipmap generation only allocates levels up to the max level or down to 1x1
+  std::size_t gpu_bytes = 0;
+  std::size_t width = m_layer_width;
+  std::size_t height = m_layer_height;
+  for (GLint level = 0; level <= max_level; ++level) {
+    gpu_bytes += width * height * 4 * m_layers;
+    if (width == 1 && height == 1) {
+      break;
+    }
+    width = std::max<std::size_t>(width / 2, 1);
+    height = std::max<std::size_t>(height / 2, 1);
+  }
+
+  // the gpu holds the only copy now
+  m_images.clear();
+  m_images.shrink_to_fit();
+  asset_memory::instance().set_cpu_bytes(m_asset, 0);
+  asset_memory::instance().set_gpu_bytes(m_asset, gpu_bytes);
+}
+
+texture_atlas::surface const& texture_atlas::get(std::uint32_t index) const {
+  return m_surfaces.at(index);
+}
+
+std::size_t texture_atlas::size() const {
+  return m_surfaces.size();
+}
+
+texture_object const& texture_atlas::texture() const {
+  return m_texture;
+}
+
+std::size_t texture_atlas::layer_width() const {
+  return m_layer_width;
+}
+
+std::size_t texture_atlas::layer_height() const {
+  return m_layer_height;
+}
+
+std::size_t texture_atlas::layers() const {
+  return m_layers;
+}
+
+float texture_atlas::atlas_occupancy() const {
+  return m_atlas_occupancy;
+}
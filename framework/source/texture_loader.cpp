@@ -21,34 +21,15 @@ pixel_data file(std::string const& file_name) {
   int width = 0;
   int height = 0;
   int format = STBI_default;
+  // format receives the components stored in the file, the data is always expanded to rgba
   data_ptr = stbi_load(file_name.c_str(), &width, &height, &format, STBI_rgb_alpha);
 
   if(!data_ptr) {
     throw std::logic_error(std::string{"stb_image: "} + stbi_failure_reason());
   }
 
-  // determine format of image data, internal format should be sized
-  GLenum pixel_format = GL_NONE;
-  std::size_t num_components = 0;
-  if (format == STBI_grey) {
-    pixel_format = GL_RED;
-    num_components = 1;
-  }
-  else if (format == STBI_grey_alpha) {
-    pixel_format = GL_RG;
-    num_components = 2;
-  }
-  else if (format == STBI_rgb) {
-    pixel_format = GL_RGB;
-    num_components = 3;
-  }
-  else if (format == STBI_rgb_alpha) {
-    pixel_format = GL_RGBA;
-    num_components = 4;
-  }
-  else {
-    throw std::logic_error("stb_image: misinterpreted data, incorrect format");
-  }
+  GLenum pixel_format = GL_RGBA;
+  std::size_t num_components = 4;
 
   std::vector<uint8_t> texture_data(width * height * num_components);
   // copy data to vector
@@ -1,8 +1,49 @@
 #version 150
 
 in  vec3 pass_Normal;
+in  vec3 pass_TexCoord;
+in  vec3 pass_ViewPosition;
+in  float pass_Emission;
 out vec4 out_Color;
 
+// surfaces of all bodies, bound to unit 0
+uniform sampler2DArray Surfaces;
+// first index and count of every cluster, x varies fastest, then y, then the slice
+uniform usamplerBuffer ClusterRanges;
+// light indices of all clusters back to back
+uniform usamplerBuffer ClusterIndices;
+// two texels per light in view space, position and radius, then colour
+uniform samplerBuffer Lights;
+// tiles in x and y, slices and the ambient light
+uniform vec4 ClusterGrid;
+// slice of a fragment is log(depth) * x + y
+uniform vec4 ClusterDepth;
+uniform mat4 ProjectionMatrix;
+
 void main() {
-  out_Color = vec4(abs(normalize(pass_Normal)), 1.0);
+  vec3 albedo = abs(normalize(pass_Normal)) * texture(Surfaces, pass_TexCoord).rgb;
+  if (pass_Emission > 0.5) {
+    out_Color = vec4(albedo, 1.0);
+    return;
+  }
+
+  // cluster from the position on screen and the view depth
+  vec4 clip = ProjectionMatrix * vec4(pass_ViewPosition, 1.0);
+  vec2 tile = clamp((clip.xy / clip.w * 0.5 + 0.5) * ClusterGrid.xy, vec2(0.0), ClusterGrid.xy - 1.0);
+  float slice = clamp(floor(log(-pass_ViewPosition.z) * ClusterDepth.x + ClusterDepth.y), 0.0, ClusterGrid.z - 1.0);
+  int cluster = int(tile.x) + int(ClusterGrid.x) * (int(tile.y) + int(ClusterGrid.y) * int(slice));
+  uvec2 range = texelFetch(ClusterRanges, cluster).xy;
+
+  vec3 normal = normalize(pass_Normal);
+  vec3 light = vec3(ClusterGrid.w);
+  for (uint i = range.x; i < range.x + range.y; ++i) {
+    int index = int(texelFetch(ClusterIndices, int(i)).x);
+    vec4 position_radius = texelFetch(Lights, 2 * index);
+    vec3 to_light = position_radius.xyz - pass_ViewPosition;
+    float distance = length(to_light);
+    // smooth falloff reaching zero at the radius, the radius used for culling
+    float falloff = max(1.0 - distance / position_radius.w, 0.0);
+    light += texelFetch(Lights, 2 * index + 1).rgb * falloff * falloff * max(dot(normal, to_light / distance), 0.0);
+  }
+  out_Color = vec4(albedo * light, 1.0);
 }
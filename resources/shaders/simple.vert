@@ -3,17 +3,32 @@
 // vertex attributes of VAO
 layout(location = 0) in vec3 in_Position;
 layout(location = 1) in vec3 in_Normal;
+layout(location = 2) in vec2 in_TexCoord;
+// per instance attributes, every matrix takes four locations
+layout(location = 3) in mat4 in_ModelMatrix;
+layout(location = 7) in mat4 in_NormalMatrix;
+// offset and scale of the surface in the texture array and its layer
+layout(location = 11) in vec4 in_SurfaceRect;
+layout(location = 12) in float in_SurfaceLayer;
+// 1 for bodies that are not lit
+layout(location = 13) in float in_Emission;
 
 //Matrix Uniforms as specified with glUniformMatrix4fv
-uniform mat4 ModelMatrix;
 uniform mat4 ViewMatrix;
 uniform mat4 ProjectionMatrix;
-uniform mat4 NormalMatrix;
 
 out vec3 pass_Normal;
+out vec3 pass_TexCoord;
+out vec3 pass_ViewPosition;
+out float pass_Emission;
 
 void main(void)
 {
-	gl_Position = (ProjectionMatrix  * ViewMatrix * ModelMatrix) * vec4(in_Position, 1.0);
-	pass_Normal = (NormalMatrix * vec4(in_Normal, 0.0)).xyz;
+	vec4 view_position = ViewMatrix * in_ModelMatrix * vec4(in_Position, 1.0);
+	gl_Position = ProjectionMatrix * view_position;
+	pass_ViewPosition = view_position.xyz;
+	pass_Emission = in_Emission;
+	// normal matrix is in world space, view matrix is rigid so it transforms normals as well
+	pass_Normal = (ViewMatrix * in_NormalMatrix * vec4(in_Normal, 0.0)).xyz;
+	pass_TexCoord = vec3(in_SurfaceRect.xy + in_TexCoord * in_SurfaceRect.zw, in_SurfaceLayer);
 }
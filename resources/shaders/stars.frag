@@ -1,9 +1,10 @@
 #version 150
 
-//in  vec3 pass_Normal;
+in  vec4 pass_Color;
 out vec4 out_Color;
 
 void main()
 {
-    out_Color = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    //alpha holds the brightness from the magnitude
+    out_Color = vec4(pass_Color.rgb * pass_Color.a, 1.0f);
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 #extension GL_ARB_explicit_attrib_location : require
 // vertex attributes of VAO
 layout(location = 0) in vec3 in_Position;
-layout(location = 1) in vec3 in_Normal;
+layout(location = 1) in vec4 in_Color;
 
 //Matrix Uniforms as specified with glUniformMatrix4fv
 //uniform mat4 ModelMatrix;
@@ -10,10 +10,11 @@ uniform mat4 ViewMatrix;
 uniform mat4 ProjectionMatrix;
 //uniform mat4 NormalMatrix;
 
-//out vec3 pass_Normal;
+//colour and brightness of the star
+out vec4 pass_Color;
 
 void main(void)
 {
 	gl_Position = (ProjectionMatrix  * ViewMatrix) * vec4(in_Position, 1.0);
-	//pass_Normal = (NormalMatrix * vec4(in_Normal, 0.0)).xyz;
+	pass_Color = in_Color;
 }
\ No newline at end of file